@@ -0,0 +1,61 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define ACPI_RSDP_SIGNATURE "RSD PTR "
+#define ACPI_RSDP_SIGNATURE_SIZE 8
+#define ACPI_SDT_SIGNATURE_SIZE 4
+
+struct __attribute__((packed)) acpi_rsdp {
+  char signature[ACPI_RSDP_SIGNATURE_SIZE];
+  uint8_t checksum;
+  char oem_id[6];
+  uint8_t revision;
+  uint32_t rsdt_addr;
+  /* Fields below are only valid since revision 2. */
+  uint32_t length;
+  uint64_t xsdt_addr;
+  uint8_t extended_checksum;
+  uint8_t reserved[3];
+};
+
+/* Size covered by the checksum of revision 0. */
+#define ACPI_RSDP_V1_SIZE 20
+
+struct __attribute__((packed)) acpi_sdt_header {
+  char signature[ACPI_SDT_SIGNATURE_SIZE];
+  uint32_t length;
+  uint8_t revision;
+  uint8_t checksum;
+  char oem_id[6];
+  char oem_table_id[8];
+  uint32_t oem_revision;
+  uint32_t creator_id;
+  uint32_t creator_revision;
+};
+
+/**
+ * @brief Locate the root table from the BIOS memory area.
+ *
+ * @return int 0 on success, or -1 if ACPI is not available.
+ */
+int acpi_init();
+
+/**
+ * @brief Find a system description table by its signature.
+ *
+ * @return const struct acpi_sdt_header* Table with a valid checksum,
+ * or NULL if not found.
+ */
+const struct acpi_sdt_header *acpi_find_table(const char *signature);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* ACPI_H */
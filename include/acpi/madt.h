@@ -0,0 +1,121 @@
+#ifndef MADT_H
+#define MADT_H
+
+#include <stdint.h>
+
+#include <acpi/acpi.h>
+#include <config.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define MADT_SIGNATURE "APIC"
+
+#define MADT_ENTRY_LOCAL_APIC 0
+#define MADT_ENTRY_IO_APIC 1
+#define MADT_ENTRY_INTERRUPT_OVERRIDE 2
+#define MADT_ENTRY_LOCAL_X2APIC 9
+
+#define MADT_LOCAL_APIC_ENABLED (1U << 0)
+#define MADT_LOCAL_APIC_ONLINE_CAPABLE (1U << 1)
+
+/* Flags of interrupt source overrides, where 0 means the bus default. */
+#define MADT_IRQ_POLARITY_MASK (3U << 0)
+#define MADT_IRQ_POLARITY_ACTIVE_HIGH (1U << 0)
+#define MADT_IRQ_POLARITY_ACTIVE_LOW (3U << 0)
+#define MADT_IRQ_TRIGGER_MASK (3U << 2)
+#define MADT_IRQ_TRIGGER_EDGE (1U << 2)
+#define MADT_IRQ_TRIGGER_LEVEL (3U << 2)
+
+#define MADT_IO_APIC_MAX 8
+#define MADT_ISA_IRQ_COUNT 16
+
+struct __attribute__((packed)) madt {
+  struct acpi_sdt_header header;
+  uint32_t local_apic_addr;
+  uint32_t flags;
+};
+
+struct __attribute__((packed)) madt_entry_header {
+  uint8_t type;
+  uint8_t length;
+};
+
+struct __attribute__((packed)) madt_local_apic {
+  struct madt_entry_header header;
+  uint8_t processor_id;
+  uint8_t apic_id;
+  uint32_t flags;
+};
+
+/* Processors with APIC ids which do not fit in madt_local_apic. */
+struct __attribute__((packed)) madt_local_x2apic {
+  struct madt_entry_header header;
+  uint16_t reserved;
+  uint32_t x2apic_id;
+  uint32_t flags;
+  uint32_t processor_uid;
+};
+
+struct __attribute__((packed)) madt_io_apic {
+  struct madt_entry_header header;
+  uint8_t io_apic_id;
+  uint8_t reserved;
+  uint32_t io_apic_addr;
+  uint32_t gsi_base;
+};
+
+struct __attribute__((packed)) madt_interrupt_override {
+  struct madt_entry_header header;
+  uint8_t bus;
+  uint8_t source;
+  uint32_t gsi;
+  uint16_t flags;
+};
+
+struct madt_io_apic_info {
+  uint32_t id;
+  uint32_t addr;
+  uint32_t gsi_base;
+};
+
+/* Global system interrupt an ISA IRQ is connected to. */
+struct madt_isa_irq_info {
+  uint32_t gsi;
+  uint16_t flags;
+};
+
+/**
+ * Interrupt controllers described by the MADT,
+ * in the form the rest of the kernel wants.
+ */
+struct madt_info {
+  uint32_t cpu_count;
+  /* Processors which are disabled or beyond CONFIG_MAX_CPUS are dropped. */
+  uint32_t cpu_apic_ids[CONFIG_MAX_CPUS];
+
+  uint32_t io_apic_count;
+  struct madt_io_apic_info io_apics[MADT_IO_APIC_MAX];
+
+  /* ISA IRQs are identity mapped with the ISA defaults unless overridden. */
+  struct madt_isa_irq_info isa_irqs[MADT_ISA_IRQ_COUNT];
+};
+
+/**
+ * @brief Parse the MADT, which should be called after acpi_init.
+ *
+ * @return int 0 on success, or -1 if the table is not available.
+ */
+int madt_init();
+
+/**
+ * @brief Get the result of madt_init, which is NULL until it succeeds.
+ */
+const struct madt_info *madt_get();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* MADT_H */
@@ -0,0 +1,41 @@
+#ifndef IOAPIC_H
+#define IOAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Set up the I/O APICs in the MADT, with every input masked.
+ *
+ * @return int 0 on success, or -1 if there is no usable I/O APIC.
+ */
+int ioapic_init();
+
+/**
+ * @brief Deliver the global system interrupt to a processor, and unmask it.
+ *
+ * @return int 0 on success, or -1 if no I/O APIC has the input.
+ */
+int ioapic_route_gsi(uint32_t gsi, uint8_t vector, uint32_t apic_id,
+                     bool level_triggered, bool active_low);
+
+/**
+ * @brief Same as ioapic_route_gsi for an ISA IRQ,
+ * which follows the interrupt source overrides in the MADT.
+ */
+int ioapic_route_isa_irq(unsigned int irq, uint8_t vector, uint32_t apic_id);
+
+/**
+ * @brief Mask the global system interrupt.
+ */
+void ioapic_mask_gsi(uint32_t gsi);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* IOAPIC_H */
@@ -0,0 +1,106 @@
+#ifndef LAPIC_H
+#define LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Vector of spurious interrupts, which should not be acknowledged. */
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+/**
+ * @brief Locate the local APIC of the bootstrap processor.
+ *
+ * Every processor sees its own local APIC at the same address,
+ * so this is only done once. x2APIC mode is used when the processor
+ * supports it, where registers are MSRs instead of MMIO.
+ *
+ * @return int 0 on success, or -1 if the local APIC is not usable.
+ */
+int lapic_init();
+
+/**
+ * @brief Enable the local APIC of the calling processor.
+ *
+ * This accepts interrupts of every priority. It should be called
+ * on each processor after lapic_init.
+ */
+void lapic_enable();
+
+/**
+ * @brief Acknowledge the interrupt being serviced on the calling processor.
+ */
+void lapic_eoi();
+
+/**
+ * @brief APIC id of the calling processor.
+ */
+uint32_t lapic_id();
+
+/**
+ * @brief Whether lapic_init selected x2APIC mode.
+ */
+bool lapic_x2apic_enabled();
+
+/**
+ * @brief Put the target processor into the wait for startup state.
+ */
+void lapic_send_init(uint32_t apic_id);
+
+/**
+ * @brief Start the target processor in real mode at vector << 12.
+ */
+void lapic_send_startup(uint32_t apic_id, uint8_t vector);
+
+/**
+ * @brief Raise the vector on the target processor.
+ */
+void lapic_send_fixed(uint32_t apic_id, uint8_t vector);
+
+/**
+ * @brief Whether the local APIC timer can fire at a time stamp counter
+ * deadline, which saves converting time to bus clock counts.
+ */
+bool lapic_tsc_deadline_supported();
+
+/**
+ * @brief Set up the local APIC timer of the calling processor
+ * to fire once on the vector each time it is armed.
+ *
+ * The timer is left disarmed.
+ *
+ * @param tsc_deadline Use TSC-deadline mode, which is armed with
+ * lapic_timer_arm_deadline, instead of lapic_timer_arm.
+ */
+void lapic_timer_init(uint8_t vector, bool tsc_deadline);
+
+/**
+ * @brief Fire after count ticks of the bus clock divided by 16,
+ * replacing the previous count. 0 disarms the timer.
+ */
+void lapic_timer_arm(uint32_t count);
+
+/**
+ * @brief Fire once the time stamp counter reaches tsc, replacing
+ * the previous deadline. 0 disarms the timer.
+ */
+void lapic_timer_arm_deadline(uint64_t tsc);
+
+/**
+ * @brief Ticks left until the timer armed by lapic_timer_arm fires.
+ */
+uint32_t lapic_timer_count();
+
+/**
+ * @brief Disarm and mask the local APIC timer of the calling processor.
+ */
+void lapic_timer_stop();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* LAPIC_H */
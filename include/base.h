@@ -1,14 +1,24 @@
 #ifndef BASE_H
 #define BASE_H
 
+#include <stddef.h>
+
 #ifndef NULL
 #define NULL ((void *)0)
 #endif /* NULL */
 
+/* Structure of the type whose member ptr points to. */
+#ifndef container_of
+#define container_of(ptr, type, member)                                        \
+  ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif /* container_of */
+
 #ifdef __GNUC__
 #define PRINTFLIKE(a, b) __attribute__((format(printf, (a), (b))))
+#define NORETURN __attribute__((noreturn))
 #else
 #define PRINTFLIKE(a, b)
+#define NORETURN
 #endif /* __GNUC__ */
 
 #endif /* BASE_H */
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef ATA_H
+#define ATA_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define ATA_SECTOR_SIZE 0x200
+
+/**
+ * @brief Setup the primary ATA drive for reading.
+ *
+ * Multiple mode is enabled if the drive accepts it,
+ * and bus master DMA is used if an IDE controller is found on PCI.
+ */
+void ata_init();
+
+/**
+ * @brief Read sectors from the primary ATA drive.
+ *
+ * Bus master DMA is tried first, and PIO is used as a fallback.
+ *
+ * @param buffer Memory address to read sectors into.
+ * @param lba Sector address to read from.
+ * @param nsector Number of sectors to read.
+ * @return int 0 on success, -1 on drive error.
+ */
+int ata_read(void *buffer, uint32_t lba, uint32_t nsector);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* ATA_H */
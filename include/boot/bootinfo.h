@@ -0,0 +1,132 @@
+#ifndef BOOTINFO_H
+#define BOOTINFO_H
+
+#include <stdint.h>
+
+#include <boot/e820.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Information handed from the boot loader to the kernel.
+ * It is placed in the free conventional memory below the boot stack,
+ * and the kernel should check the magic before trusting anything in it.
+ *
+ * Stage 2 enters the kernel with BOOT_INFO_MAGIC in eax and BOOT_INFO_ADDR
+ * in ebx, just as Multiboot loaders do with their own information.
+ */
+#define BOOT_INFO_ADDR 0x1000
+#define BOOT_INFO_SIZE_MAX 0x3000
+#define BOOT_INFO_MAGIC 0x474E524F /* "ORNG" */
+
+#define BOOT_INFO_FLAG_KERNEL_LZ4 (1U << 0)
+#define BOOT_INFO_FLAG_E820 (1U << 1)
+#define BOOT_INFO_FLAG_MULTIBOOT (1U << 2)
+#define BOOT_INFO_FLAG_FRAMEBUFFER (1U << 3)
+
+#define BOOT_INFO_MODULE_MAX 8
+#define BOOT_INFO_CMDLINE_MAX 64
+
+/**
+ * Checkpoints on the boot timeline, in the order they are reached.
+ * The first ones are stamped by the boot loader and handed over
+ * in the boot information, and the rest are stamped by the kernel.
+ */
+enum boot_phase {
+  BOOT_PHASE_BOOT_SECTOR,
+  BOOT_PHASE_STAGE2,
+  BOOT_PHASE_KERNEL_READ,
+  BOOT_PHASE_KERNEL_LOADED,
+  BOOT_PHASE_KERNEL_START,
+  BOOT_PHASE_TERMINAL_INIT,
+  BOOT_PHASE_MEMMAP_INIT,
+  BOOT_PHASE_KTIME_INIT,
+  BOOT_PHASE_IDT_INIT,
+  BOOT_PHASE_SMP_INIT,
+  BOOT_PHASE_COUNT,
+};
+
+#define BOOT_PHASE_LOADER_COUNT BOOT_PHASE_KERNEL_START
+
+/**
+ * Stage 2 is always 32 bit while the kernel may be 64 bit,
+ * so 64 bit fields are kept at 8 byte aligned offsets
+ * for the layout to be the same on both.
+ */
+struct boot_info {
+  uint32_t magic;
+  uint32_t flags;
+
+  /* Valid if BOOT_INFO_FLAG_KERNEL_LZ4 is set. */
+  struct {
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint64_t decode_cycles;
+  } kernel_lz4;
+
+  /* Time stamp counter at each loader checkpoint, or 0 if not reached. */
+  uint64_t timeline[BOOT_PHASE_LOADER_COUNT];
+
+  /* Valid if BOOT_INFO_FLAG_E820 is set, sorted and without overlaps. */
+  uint32_t e820_count;
+  struct e820_entry e820[E820_ENTRY_MAX];
+
+  /**
+   * The rest are only filled by Multiboot loaders.
+   * Modules are left in place, and command lines are truncated.
+   */
+  char cmdline[BOOT_INFO_CMDLINE_MAX];
+
+  uint32_t module_count;
+  struct {
+    uint32_t start;
+    uint32_t end;
+    char cmdline[BOOT_INFO_CMDLINE_MAX];
+  } modules[BOOT_INFO_MODULE_MAX];
+
+  /* Valid if BOOT_INFO_FLAG_FRAMEBUFFER is set. */
+  struct {
+    uint64_t addr;
+    uint32_t pitch;
+    uint32_t width;
+    uint32_t height;
+    uint8_t bpp;
+    uint8_t type;
+  } framebuffer;
+};
+
+/**
+ * @brief Boot information in the place stage 2 writes it.
+ *
+ * This is for the boot loader. Kernel should use kernel_boot_info,
+ * which does not depend on the boot protocol.
+ */
+static inline struct boot_info *boot_info_get() {
+  return (struct boot_info *)BOOT_INFO_ADDR;
+}
+
+static inline int boot_info_valid(const struct boot_info *info) {
+  return info->magic == BOOT_INFO_MAGIC;
+}
+
+/**
+ * @brief Collect the boot information into the kernel.
+ *
+ * Information from Multiboot loaders is converted to struct boot_info,
+ * so that the rest of the kernel does not depend on the boot protocol.
+ * This should be called before any memory is handed to the allocator.
+ *
+ * @param magic Value of eax on kernel entry.
+ * @param addr Value of ebx on kernel entry.
+ */
+void boot_info_init(uint32_t magic, uint32_t addr);
+
+const struct boot_info *kernel_boot_info();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* BOOTINFO_H */
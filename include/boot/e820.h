@@ -0,0 +1,50 @@
+#ifndef E820_H
+#define E820_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Memory map returned by the BIOS.
+ * See also: Ralf Brown's interrupt list, INT 15 - newer BIOSes - GET SYSTEM MEMORY MAP
+ */
+#define E820_TYPE_USABLE 1
+#define E820_TYPE_RESERVED 2
+#define E820_TYPE_ACPI_RECLAIMABLE 3
+#define E820_TYPE_ACPI_NVS 4
+#define E820_TYPE_BAD 5
+
+/* ACPI 3.0 extended attributes, where the entry should be ignored if clear. */
+#define E820_ATTR_ENABLED (1U << 0)
+
+/* This should match <src/boot/stage2.asm>. */
+#define E820_ENTRY_MAX 32
+
+struct __attribute__((packed)) e820_entry {
+  uint64_t base;
+  uint64_t length;
+  uint32_t type;
+  uint32_t attr;
+};
+
+/**
+ * @brief Sort the entries by address and resolve overlaps.
+ *
+ * Adjacent entries of the same type are merged, and overlapping parts
+ * get the most restrictive type, so that no reserved memory is reported
+ * as usable.
+ *
+ * @param dst Sanitized map, which may hold up to 2 * count - 1 entries.
+ * @return uint32_t Number of entries written to dst.
+ */
+uint32_t e820_sanitize(const struct e820_entry *src, uint32_t count,
+                       struct e820_entry *dst, uint32_t max);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* E820_H */
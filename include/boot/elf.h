@@ -0,0 +1,57 @@
+#ifndef ELF_H
+#define ELF_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define ELF_IDENT_SIZE 16
+
+#define ELF_IDENT_CLASS 4
+#define ELF_IDENT_DATA 5
+
+#define ELF_MAGIC "\x7f" "ELF"
+#define ELF_MAGIC_SIZE 4
+
+#define ELF_CLASS_32 1
+#define ELF_DATA_LSB 1
+#define ELF_TYPE_EXEC 2
+#define ELF_MACHINE_386 3
+
+#define ELF_PT_LOAD 1
+
+struct elf32_ehdr {
+  uint8_t ident[ELF_IDENT_SIZE];
+  uint16_t type;
+  uint16_t machine;
+  uint32_t version;
+  uint32_t entry;
+  uint32_t phoff;
+  uint32_t shoff;
+  uint32_t flags;
+  uint16_t ehsize;
+  uint16_t phentsize;
+  uint16_t phnum;
+  uint16_t shentsize;
+  uint16_t shnum;
+  uint16_t shstrndx;
+};
+
+struct elf32_phdr {
+  uint32_t type;
+  uint32_t offset;
+  uint32_t vaddr;
+  uint32_t paddr;
+  uint32_t filesz;
+  uint32_t memsz;
+  uint32_t flags;
+  uint32_t align;
+};
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* ELF_H */
@@ -0,0 +1,47 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define LZ4_KERNEL_MAGIC "OLZ4"
+#define LZ4_KERNEL_MAGIC_SIZE 4
+
+/**
+ * Header of the compressed kernel payload produced by <tools/lz4pack.c>.
+ * The payload is a flat image of all PT_LOAD segments starting at load_addr,
+ * compressed as a single LZ4 block that follows the header.
+ */
+struct lz4_kernel_header {
+  char magic[LZ4_KERNEL_MAGIC_SIZE];
+  uint32_t header_size;
+  uint32_t entry;
+  uint32_t load_addr;
+  /* Size of the flat image after decompression. */
+  uint32_t image_size;
+  /* Size of memory used by the kernel, where the tail is zero filled. */
+  uint32_t mem_size;
+  uint32_t compressed_size;
+  uint32_t reserved;
+};
+
+/**
+ * @brief Decompress a single LZ4 block.
+ *
+ * @param src Compressed block.
+ * @param src_size Size of compressed block.
+ * @param dst Buffer to decompress into.
+ * @param dst_size Size of the buffer.
+ * @return int Size of decompressed data, or -1 if the block is malformed.
+ */
+int lz4_decompress(const void *src, uint32_t src_size, void *dst,
+                   uint32_t dst_size);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* LZ4_H */
@@ -0,0 +1,127 @@
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Boot information passed by Multiboot compliant boot loaders.
+ * The headers themselves are in <src/kernel.asm>.
+ *
+ * Multiboot 1 is what qemu -kernel supports, and Multiboot 2 is for GRUB.
+ * See also: https://www.gnu.org/software/grub/manual/multiboot/multiboot.html
+ * See also: https://www.gnu.org/software/grub/manual/multiboot2/multiboot.html
+ */
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+#define MULTIBOOT2_BOOTLOADER_MAGIC 0x36D76289
+
+#define MULTIBOOT_INFO_CMDLINE (1U << 2)
+#define MULTIBOOT_INFO_MODS (1U << 3)
+#define MULTIBOOT_INFO_MEM_MAP (1U << 6)
+#define MULTIBOOT_INFO_FRAMEBUFFER (1U << 12)
+
+struct __attribute__((packed)) multiboot_info {
+  uint32_t flags;
+  uint32_t mem_lower;
+  uint32_t mem_upper;
+  uint32_t boot_device;
+  uint32_t cmdline;
+  uint32_t mods_count;
+  uint32_t mods_addr;
+  uint32_t syms[4];
+  uint32_t mmap_length;
+  uint32_t mmap_addr;
+  uint32_t drives_length;
+  uint32_t drives_addr;
+  uint32_t config_table;
+  uint32_t boot_loader_name;
+  uint32_t apm_table;
+  uint32_t vbe_control_info;
+  uint32_t vbe_mode_info;
+  uint16_t vbe_mode;
+  uint16_t vbe_interface_seg;
+  uint16_t vbe_interface_off;
+  uint16_t vbe_interface_len;
+  uint64_t framebuffer_addr;
+  uint32_t framebuffer_pitch;
+  uint32_t framebuffer_width;
+  uint32_t framebuffer_height;
+  uint8_t framebuffer_bpp;
+  uint8_t framebuffer_type;
+};
+
+/* Size does not count the size field itself. */
+struct __attribute__((packed)) multiboot_mmap_entry {
+  uint32_t size;
+  uint64_t addr;
+  uint64_t len;
+  uint32_t type;
+};
+
+struct __attribute__((packed)) multiboot_module {
+  uint32_t mod_start;
+  uint32_t mod_end;
+  uint32_t cmdline;
+  uint32_t reserved;
+};
+
+#define MULTIBOOT2_TAG_ALIGN 8
+
+#define MULTIBOOT2_TAG_TYPE_END 0
+#define MULTIBOOT2_TAG_TYPE_CMDLINE 1
+#define MULTIBOOT2_TAG_TYPE_MODULE 3
+#define MULTIBOOT2_TAG_TYPE_MMAP 6
+#define MULTIBOOT2_TAG_TYPE_FRAMEBUFFER 8
+
+struct __attribute__((packed)) multiboot2_info {
+  uint32_t total_size;
+  uint32_t reserved;
+};
+
+struct __attribute__((packed)) multiboot2_tag {
+  uint32_t type;
+  uint32_t size;
+};
+
+struct __attribute__((packed)) multiboot2_tag_string {
+  uint32_t type;
+  uint32_t size;
+  char string[];
+};
+
+struct __attribute__((packed)) multiboot2_tag_module {
+  uint32_t type;
+  uint32_t size;
+  uint32_t mod_start;
+  uint32_t mod_end;
+  char cmdline[];
+};
+
+/* Entries are laid out the same as E820 entries. */
+struct __attribute__((packed)) multiboot2_tag_mmap {
+  uint32_t type;
+  uint32_t size;
+  uint32_t entry_size;
+  uint32_t entry_version;
+};
+
+struct __attribute__((packed)) multiboot2_tag_framebuffer {
+  uint32_t type;
+  uint32_t size;
+  uint64_t framebuffer_addr;
+  uint32_t framebuffer_pitch;
+  uint32_t framebuffer_width;
+  uint32_t framebuffer_height;
+  uint8_t framebuffer_bpp;
+  uint8_t framebuffer_type;
+  uint16_t reserved;
+};
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* MULTIBOOT_H */
@@ -0,0 +1,48 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define PCI_CONFIG_VENDOR_ID 0x00
+#define PCI_CONFIG_COMMAND 0x04
+#define PCI_CONFIG_CLASS_REVISION 0x08
+#define PCI_CONFIG_HEADER_TYPE 0x0C
+#define PCI_CONFIG_BAR4 0x20
+
+#define PCI_COMMAND_IO_SPACE 0x0001
+#define PCI_COMMAND_BUS_MASTER 0x0004
+
+#define PCI_CLASS_STORAGE 0x01
+#define PCI_SUBCLASS_STORAGE_IDE 0x01
+
+struct pci_location {
+  uint8_t bus;
+  uint8_t device;
+  uint8_t function;
+};
+
+uint32_t pci_config_read32(const struct pci_location *loc, uint8_t offset);
+
+void pci_config_write32(const struct pci_location *loc, uint8_t offset,
+                        uint32_t value);
+
+/**
+ * @brief Find the first function on bus 0 with the given class and subclass.
+ *
+ * @param class_code Base class code of the function.
+ * @param subclass Subclass code of the function.
+ * @param loc Location of the function found.
+ * @return int 0 if found, -1 otherwise.
+ */
+int pci_find_class(uint8_t class_code, uint8_t subclass,
+                   struct pci_location *loc);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PCI_H */
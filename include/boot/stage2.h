@@ -0,0 +1,16 @@
+#ifndef STAGE2_H
+#define STAGE2_H
+
+#include <base.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void stage2_main();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* STAGE2_H */
@@ -2,7 +2,7 @@
 #define CONFIG_H
 
 /**
- * This is a symbol in <src/boot/boot.asm>.
+ * These are symbols in <src/boot/stage2.asm> and <src/kernel.asm>.
  * It should actually be asserted for equality,
  * but this seems to require gnu assembler,
  * so just rely on manual assertion for now.
@@ -14,4 +14,7 @@
 
 #define CONFIG_NUM_INTERRUPTS 0x100
 
+/* Processors beyond this are left halted. */
+#define CONFIG_MAX_CPUS 16
+
 #endif /* CONFIG_H */
\ No newline at end of file
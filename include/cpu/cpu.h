@@ -0,0 +1,113 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Read the time stamp counter.
+ *
+ * This is not serializing, so surrounding instructions may be reordered
+ * around it. This is fine for measuring boot phases and such.
+ */
+static inline uint64_t x86_rdtsc() {
+  uint32_t lo, hi;
+  __asm__ inline volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+#define X86_EFLAGS_IF (1U << 9)
+
+#define X86_CPUID_FEATURE_ECX_X2APIC (1U << 21)
+#define X86_CPUID_FEATURE_ECX_TSC_DEADLINE (1U << 24)
+#define X86_CPUID_FEATURE_EDX_MSR (1U << 5)
+#define X86_CPUID_FEATURE_EDX_APIC (1U << 9)
+
+#define X86_MSR_APIC_BASE 0x1B
+#define X86_MSR_GS_BASE 0xC0000101
+
+static inline void x86_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+                             uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+  __asm__ inline volatile("cpuid"
+                          : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                          : "a"(leaf), "c"(subleaf));
+}
+
+static inline uint64_t x86_rdmsr(uint32_t msr) {
+  uint32_t lo, hi;
+  __asm__ inline volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void x86_wrmsr(uint32_t msr, uint64_t value) {
+  __asm__ inline volatile("wrmsr"
+                          :
+                          : "c"(msr), "a"((uint32_t)value),
+                            "d"((uint32_t)(value >> 32)));
+}
+
+/**
+ * @brief Hint that the processor is spinning on a lock or a flag.
+ */
+static inline void x86_pause() { __asm__ inline volatile("pause"); }
+
+static inline void x86_halt() { __asm__ inline volatile("hlt"); }
+
+/**
+ * @brief Enable interrupts and halt until the next one.
+ *
+ * sti takes effect after the next instruction, so no interrupt
+ * can slip in between and leave the processor halted with work to do.
+ */
+static inline void x86_safe_halt() {
+  __asm__ inline volatile("sti\n\t"
+                          "hlt"
+                          :
+                          :
+                          : "memory");
+}
+
+/**
+ * @brief Read the faulting address of the last page fault.
+ */
+static inline uintptr_t x86_read_cr2() {
+  uintptr_t cr2;
+  __asm__ inline volatile("mov %%cr2, %0" : "=r"(cr2));
+  return cr2;
+}
+
+static inline void x86_irq_enable() {
+  __asm__ inline volatile("sti" : : : "memory");
+}
+
+static inline void x86_irq_disable() {
+  __asm__ inline volatile("cli" : : : "memory");
+}
+
+/**
+ * @brief Disable interrupts, and return the flags to restore them with.
+ */
+static inline unsigned long x86_irq_save() {
+  unsigned long flags;
+  __asm__ inline volatile("pushf\n\t"
+                          "pop %0\n\t"
+                          "cli"
+                          : "=r"(flags)
+                          :
+                          : "memory");
+  return flags;
+}
+
+static inline void x86_irq_restore(unsigned long flags) {
+  if (flags & X86_EFLAGS_IF)
+    __asm__ inline volatile("sti" : : : "memory");
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* CPU_H */
@@ -0,0 +1,49 @@
+#ifndef GDT_H
+#define GDT_H
+
+#include <stdint.h>
+
+#include <config.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Layout of the GDT, which is shared by every processor.
+ * Code and data segments are at the same place as the GDT
+ * in <src/kernel.asm>, so that the selectors stay valid across the switch.
+ */
+#define GDT_ENTRY_NULL 0
+#define GDT_ENTRY_KERNEL_CODE 1
+#define GDT_ENTRY_KERNEL_DATA 2
+/* GS segment of each processor, which points to its per-CPU area. */
+#define GDT_ENTRY_PERCPU_BASE 3
+#define GDT_ENTRY_COUNT (GDT_ENTRY_PERCPU_BASE + CONFIG_MAX_CPUS)
+
+#define GDT_SELECTOR(entry) ((entry) << 3)
+#define GDT_PERCPU_SELECTOR(cpu) GDT_SELECTOR(GDT_ENTRY_PERCPU_BASE + (cpu))
+
+/**
+ * @brief Build the GDT and load it on the bootstrap processor.
+ */
+void gdt_init();
+
+/**
+ * @brief Load the GDT on the calling processor.
+ */
+void gdt_load();
+
+/**
+ * @brief Set the base of the GS segment of the processor.
+ *
+ * Only the low 32 bits are used in long mode, where the base
+ * is taken from the GS base MSR instead.
+ */
+void gdt_set_percpu_base(unsigned int cpu, uintptr_t base);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* GDT_H */
@@ -0,0 +1,122 @@
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include <stdint.h>
+
+#include <config.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Per-CPU variables are placed in this section, which is the area
+ * of the bootstrap processor. Each application processor gets
+ * a zero filled copy, and its GS base is set to the offset of the copy,
+ * so that %gs:&var is the copy of var on the running processor.
+ *
+ * Copies are zero filled like .bss, so variables should not have
+ * an initializer. Accessors work on variables up to the word size.
+ */
+#define PER_CPU_SECTION ".bss.percpu"
+
+#define DEFINE_PER_CPU(type, name)                                             \
+  __attribute__((section(PER_CPU_SECTION))) __typeof__(type) name
+#define DECLARE_PER_CPU(type, name) extern __typeof__(type) name
+
+/* Offset of the per-CPU area of each processor, from the one above. */
+extern uintptr_t percpu_offsets[CONFIG_MAX_CPUS];
+
+DECLARE_PER_CPU(unsigned int, percpu_cpu);
+DECLARE_PER_CPU(uintptr_t, percpu_offset);
+
+#define PERCPU_CHECK_SIZE(var)                                                 \
+  ((void)sizeof(char[sizeof(var) <= sizeof(long) ? 1 : -1]))
+
+#define this_cpu_read(var)                                                     \
+  ({                                                                           \
+    __typeof__(var) __percpu_ret;                                              \
+    PERCPU_CHECK_SIZE(var);                                                    \
+    __asm__ volatile("mov %%gs:%1, %0" : "=q"(__percpu_ret) : "m"(var));       \
+    __percpu_ret;                                                              \
+  })
+
+#define this_cpu_write(var, val)                                               \
+  do {                                                                         \
+    PERCPU_CHECK_SIZE(var);                                                    \
+    __asm__ volatile("mov%z0 %1, %%gs:%0"                                      \
+                     : "=m"(var)                                               \
+                     : "qe"((__typeof__(var))(val)));                          \
+  } while (0)
+
+#define this_cpu_add(var, val)                                                 \
+  do {                                                                         \
+    PERCPU_CHECK_SIZE(var);                                                    \
+    __asm__ volatile("add%z0 %1, %%gs:%0"                                      \
+                     : "+m"(var)                                               \
+                     : "qe"((__typeof__(var))(val)));                          \
+  } while (0)
+
+#define this_cpu_or(var, val)                                                  \
+  do {                                                                         \
+    PERCPU_CHECK_SIZE(var);                                                    \
+    __asm__ volatile("or%z0 %1, %%gs:%0"                                       \
+                     : "+m"(var)                                               \
+                     : "qe"((__typeof__(var))(val)));                          \
+  } while (0)
+
+#define this_cpu_inc(var)                                                      \
+  do {                                                                         \
+    PERCPU_CHECK_SIZE(var);                                                    \
+    __asm__ volatile("inc%z0 %%gs:%0" : "+m"(var));                            \
+  } while (0)
+
+/**
+ * @brief Address of the copy of var on the running processor.
+ *
+ * This should be used with preemption disabled, since the processor
+ * may change right after.
+ */
+#define this_cpu_ptr(var)                                                      \
+  ((__typeof__(var) *)((uintptr_t)&(var) + this_cpu_read(percpu_offset)))
+
+/**
+ * @brief Address of the copy of var on the processor.
+ */
+#define per_cpu_ptr(var, cpu)                                                  \
+  ((__typeof__(var) *)((uintptr_t)&(var) + percpu_offsets[(cpu)]))
+
+/**
+ * @brief Set up the GDT and the per-CPU area of the bootstrap processor.
+ *
+ * This should be called before anything else, so that per-CPU variables
+ * are available from the start.
+ */
+void percpu_init();
+
+/**
+ * @brief Allocate the per-CPU area of an application processor.
+ *
+ * @return int 0 on success, -1 if the allocation fails.
+ */
+int percpu_alloc(unsigned int cpu);
+
+/**
+ * @brief Release the per-CPU area of a processor which did not start.
+ */
+void percpu_free(unsigned int cpu);
+
+/**
+ * @brief Load the per-CPU area on the calling application processor.
+ */
+void percpu_init_ap(unsigned int cpu);
+
+static inline unsigned int smp_processor_id() {
+  return this_cpu_read(percpu_cpu);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PERCPU_H */
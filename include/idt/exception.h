@@ -0,0 +1,52 @@
+#ifndef EXCEPTION_H
+#define EXCEPTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define X86_EXCEPTION_DIVIDE_ERROR 0x00
+#define X86_EXCEPTION_DEBUG 0x01
+#define X86_EXCEPTION_NMI 0x02
+#define X86_EXCEPTION_BREAKPOINT 0x03
+#define X86_EXCEPTION_OVERFLOW 0x04
+#define X86_EXCEPTION_BOUND_RANGE 0x05
+#define X86_EXCEPTION_INVALID_OPCODE 0x06
+#define X86_EXCEPTION_DEVICE_NOT_AVAILABLE 0x07
+#define X86_EXCEPTION_DOUBLE_FAULT 0x08
+#define X86_EXCEPTION_INVALID_TSS 0x0A
+#define X86_EXCEPTION_SEGMENT_NOT_PRESENT 0x0B
+#define X86_EXCEPTION_STACK_FAULT 0x0C
+#define X86_EXCEPTION_GENERAL_PROTECTION 0x0D
+#define X86_EXCEPTION_PAGE_FAULT 0x0E
+#define X86_EXCEPTION_X87_FLOATING_POINT 0x10
+#define X86_EXCEPTION_ALIGNMENT_CHECK 0x11
+#define X86_EXCEPTION_MACHINE_CHECK 0x12
+#define X86_EXCEPTION_SIMD_FLOATING_POINT 0x13
+#define X86_EXCEPTION_VIRTUALIZATION 0x14
+#define X86_EXCEPTION_CONTROL_PROTECTION 0x15
+#define X86_EXCEPTION_COUNT 0x20
+
+/* Bits of the page fault error code. */
+#define X86_PAGE_FAULT_PRESENT (1U << 0)
+#define X86_PAGE_FAULT_WRITE (1U << 1)
+#define X86_PAGE_FAULT_USER (1U << 2)
+#define X86_PAGE_FAULT_RESERVED (1U << 3)
+#define X86_PAGE_FAULT_FETCH (1U << 4)
+
+/**
+ * @brief Install the default handlers of the architectural exceptions.
+ *
+ * Exceptions go through irq_dispatch like any other vector,
+ * so irq_register replaces the default handler. Execution resumes
+ * at the saved instruction pointer when the handler returns,
+ * which is the faulting instruction for faults.
+ * The faulting address of a page fault is in CR2, see x86_read_cr2.
+ */
+void exception_init();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* EXCEPTION_H */
@@ -1,12 +1,30 @@
 #ifndef IDT_H
 #define IDT_H
 
+#include <idt/irq.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+/**
+ * Vector of the PIT interrupt, which is the same whether the 8259
+ * or the I/O APIC delivers it. This should match <src/idt/idt.c>.
+ */
+#define IDT_VECTOR_PIT 0x20
+
 void idt_init();
 
+/**
+ * @brief Load the table set up by idt_init on the calling processor.
+ */
+void idt_load();
+
+/**
+ * @brief Acknowledge an ISA interrupt to the controller which delivered it.
+ */
+void irq_notify_eoi(const struct trap_frame *frame);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
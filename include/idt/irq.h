@@ -0,0 +1,89 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Registers saved by the common entry in <src/idt/idt.asm>,
+ * followed by what the processor pushes on interrupt.
+ * Error code is zero for vectors without one.
+ */
+struct trap_frame {
+#ifdef CONFIG_X86_64
+  uint64_t r15;
+  uint64_t r14;
+  uint64_t r13;
+  uint64_t r12;
+  uint64_t r11;
+  uint64_t r10;
+  uint64_t r9;
+  uint64_t r8;
+  uint64_t rbp;
+  uint64_t rdi;
+  uint64_t rsi;
+  uint64_t rdx;
+  uint64_t rcx;
+  uint64_t rbx;
+  uint64_t rax;
+  uint64_t vector;
+  uint64_t error_code;
+  uint64_t rip;
+  uint64_t cs;
+  uint64_t rflags;
+  uint64_t rsp;
+  uint64_t ss;
+#else
+  /* Order of pushad, where esp is the one before pushad. */
+  uint32_t edi;
+  uint32_t esi;
+  uint32_t ebp;
+  uint32_t esp;
+  uint32_t ebx;
+  uint32_t edx;
+  uint32_t ecx;
+  uint32_t eax;
+  uint32_t vector;
+  uint32_t error_code;
+  uint32_t eip;
+  uint32_t cs;
+  uint32_t eflags;
+#endif /* CONFIG_X86_64 */
+};
+
+static inline unsigned long trap_frame_flags(const struct trap_frame *frame) {
+#ifdef CONFIG_X86_64
+  return frame->rflags;
+#else
+  return frame->eflags;
+#endif /* CONFIG_X86_64 */
+}
+
+typedef void (*irq_handler_t)(struct trap_frame *frame, void *ctx);
+
+/**
+ * @brief Set the handler of the vector, replacing the previous one.
+ *
+ * Handlers run with interrupts disabled on the interrupted stack.
+ * Interrupts should be acknowledged before the handler returns,
+ * since softirqs run with interrupts enabled right after.
+ * The vector should be masked while its handler is replaced,
+ * since the handler and ctx are not updated together.
+ *
+ * @return int 0 on success, -1 if the vector is out of range.
+ */
+int irq_register(unsigned int vector, irq_handler_t handler, void *ctx);
+
+/**
+ * @brief Remove the handler of the vector.
+ */
+void irq_unregister(unsigned int vector);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* IRQ_H */
@@ -0,0 +1,76 @@
+#ifndef IRQ_STATS_H
+#define IRQ_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <config.h>
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Bucket n counts interrupts which took [2^n, 2^(n+1)) cycles. */
+#define IRQ_STATS_BUCKET_COUNT 32
+
+/**
+ * Interrupt statistics of a processor, which are only updated by
+ * the processor itself with interrupts disabled, so no lock is needed.
+ * Latency is the time from the entry stub to the return of the handler,
+ * which leaves out softirqs.
+ */
+struct irq_stats {
+  uint32_t count[CONFIG_NUM_INTERRUPTS];
+  uint32_t latency[IRQ_STATS_BUCKET_COUNT];
+};
+
+#ifdef CONFIG_IRQ_STATS
+
+DECLARE_PER_CPU(struct irq_stats, irq_stats);
+
+extern bool irq_stats_enabled;
+
+static inline unsigned int irq_stats_bucket(uint64_t cycles) {
+  if (cycles >> 32)
+    return IRQ_STATS_BUCKET_COUNT - 1;
+  return 31 - (unsigned int)__builtin_clz((uint32_t)cycles | 1U);
+}
+
+/**
+ * @brief Account the interrupt on the calling processor.
+ *
+ * @param entry_tsc Time stamp counter taken by the entry stub.
+ */
+static inline void irq_stats_record(unsigned int vector, uint64_t entry_tsc) {
+  if (!__atomic_load_n(&irq_stats_enabled, __ATOMIC_RELAXED))
+    return;
+
+  this_cpu_inc(irq_stats.count[vector]);
+  this_cpu_inc(irq_stats.latency[irq_stats_bucket(x86_rdtsc() - entry_tsc)]);
+}
+
+/**
+ * @brief Start or stop accounting, which starts enabled.
+ */
+void irq_stats_set_enabled(bool enabled);
+
+/**
+ * @brief Print the statistics of every processor.
+ */
+void irq_stats_dump();
+
+#else
+
+static inline void irq_stats_record(unsigned int vector, uint64_t entry_tsc) {}
+static inline void irq_stats_set_enabled(bool enabled) {}
+static inline void irq_stats_dump() {}
+
+#endif /* CONFIG_IRQ_STATS */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* IRQ_STATS_H */
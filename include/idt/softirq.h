@@ -0,0 +1,86 @@
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <cpu/percpu.h>
+#include <idt/irq.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Work deferred by interrupt handlers, which runs on the same processor
+ * when the outermost interrupt returns, with interrupts enabled.
+ * Lower numbers run first.
+ */
+enum softirq {
+  SOFTIRQ_TIMER,
+  /* Runs the queue of softirq_queue_work. */
+  SOFTIRQ_WORK,
+  /* Runs the tasks of <include/sched/task.h>. */
+  SOFTIRQ_TASK,
+  SOFTIRQ_COUNT,
+};
+
+typedef void (*softirq_handler_t)();
+
+struct softirq_work {
+  struct softirq_work *next;
+  void (*fn)(void *ctx);
+  void *ctx;
+  bool queued;
+};
+
+#define SOFTIRQ_WORK_INIT(work_fn, work_ctx)                                   \
+  { .next = NULL, .fn = (work_fn), .ctx = (work_ctx), .queued = false }
+
+DECLARE_PER_CPU(uint32_t, softirq_pending);
+
+void softirq_register(enum softirq nr, softirq_handler_t handler);
+
+/**
+ * @brief Mark the softirq pending on the calling processor.
+ *
+ * This is a single instruction, so it is safe from any context.
+ */
+static inline void softirq_raise(enum softirq nr) {
+  this_cpu_or(softirq_pending, 1U << nr);
+}
+
+/**
+ * @brief Queue the work on the calling processor.
+ *
+ * fn is called once however many times the work is queued before it runs,
+ * and it may queue the work again.
+ *
+ * @return bool false if the work is already queued.
+ */
+bool softirq_queue_work(struct softirq_work *work);
+
+/**
+ * @brief Run pending softirqs on the way out of an interrupt.
+ *
+ * This is called by irq_dispatch with interrupts disabled, and does
+ * nothing if the interrupted code had interrupts disabled
+ * or is running softirqs itself.
+ */
+void softirq_irq_exit(const struct trap_frame *frame);
+
+/**
+ * @brief Run pending softirqs from thread context, where no interrupt
+ * may come for a while to run them on its way out.
+ *
+ * This does nothing with interrupts disabled, which includes interrupt
+ * handlers, or while softirqs are running, since they are run on the way
+ * out of those anyway.
+ */
+void softirq_run_pending();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* SOFTIRQ_H */
@@ -17,6 +17,12 @@ static inline unsigned short x86_inw(unsigned short port) {
   return val;
 }
 
+static inline unsigned int x86_inl(unsigned short port) {
+  unsigned int val = 0;
+  __asm__ inline("inl (%%dx), %%eax" : "=a"(val) : "d"(port));
+  return val;
+}
+
 static inline void x86_outb(unsigned short port, unsigned char val) {
   __asm__ inline("outb %%al, (%%dx)" : : "d"(port), "a"(val));
 }
@@ -25,6 +31,21 @@ static inline void x86_outw(unsigned short port, unsigned short val) {
   __asm__ inline("outw %%ax, (%%dx)" : : "d"(port), "a"(val));
 }
 
+static inline void x86_outl(unsigned short port, unsigned int val) {
+  __asm__ inline("outl %%eax, (%%dx)" : : "d"(port), "a"(val));
+}
+
+/**
+ * @brief Read count words from the port into the buffer.
+ */
+static inline void x86_insw(unsigned short port, void *buffer,
+                            unsigned long count) {
+  __asm__ inline("rep insw"
+                 : "+D"(buffer), "+c"(count)
+                 : "d"(port)
+                 : "memory");
+}
+
 static inline void x86_io_wait() {
   /**
    * @brief IO wait by reading from an unused port.
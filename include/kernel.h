@@ -1,13 +1,28 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include <stdint.h>
+
 #include <base.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
-void kernel_main();
+/**
+ * @brief Kernel entry from <src/kernel.asm>.
+ *
+ * @param boot_magic Value of eax on kernel entry, which tells the boot protocol.
+ * @param boot_addr Value of ebx on kernel entry, which points to the boot information.
+ */
+void kernel_main(uint32_t boot_magic, uint32_t boot_addr);
+
+/**
+ * @brief Entry of each application processor, once it is online.
+ *
+ * @param cpu Index of the processor, where 0 is the bootstrap processor.
+ */
+void kernel_main_ap(unsigned int cpu);
 
 #ifdef __cplusplus
 } /* extern "C" */
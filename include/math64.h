@@ -0,0 +1,53 @@
+#ifndef MATH64_H
+#define MATH64_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * 64 bit arithmetic which the 32 bit kernel cannot leave to the compiler,
+ * since there is no libgcc to provide the helpers.
+ */
+
+/**
+ * @brief Divide with two 32 bit divisions on the 32 bit kernel.
+ */
+static inline uint64_t div_u64_u32(uint64_t dividend, uint32_t divisor) {
+#ifdef CONFIG_X86_64
+  return dividend / divisor;
+#else
+  const uint32_t hi = (uint32_t)(dividend >> 32);
+  uint32_t quotient_lo, remainder = hi % divisor;
+
+  /* Remainder is below the divisor, so the quotient fits in 32 bits. */
+  __asm__("divl %[divisor]"
+          : "=a"(quotient_lo), "+d"(remainder)
+          : [divisor] "rm"(divisor), "a"((uint32_t)dividend));
+
+  return ((uint64_t)(hi / divisor) << 32) | quotient_lo;
+#endif /* CONFIG_X86_64 */
+}
+
+/**
+ * @brief (a * mul) >> shift without overflowing the 64 bit intermediate,
+ * where shift is at most 32.
+ */
+static inline uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mul,
+                                       unsigned int shift) {
+  const uint32_t hi = (uint32_t)(a >> 32);
+  uint64_t ret = ((uint64_t)(uint32_t)a * mul) >> shift;
+
+  if (hi != 0)
+    ret += ((uint64_t)hi * mul) << (32 - shift);
+
+  return ret;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* MATH64_H */
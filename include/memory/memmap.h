@@ -0,0 +1,20 @@
+#ifndef MEMMAP_H
+#define MEMMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Hand all usable memory above the kernel over to the page allocator.
+ *
+ * The memory map is taken from the boot information,
+ * and boot modules are left out so that they can be used in place.
+ */
+void memmap_init();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* MEMMAP_H */
@@ -0,0 +1,44 @@
+#ifndef PAGE_ALLOC_H
+#define PAGE_ALLOC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define PAGE_SHIFT 12U
+#define PAGE_SIZE (1UL << PAGE_SHIFT)
+#define PAGE_MASK (PAGE_SIZE - 1UL)
+
+/**
+ * @brief Hand a region of pages over to the page allocator.
+ *
+ * @param addr Start of the region, which should be PAGE_SIZE aligned.
+ * @param size Size of the region, which should be PAGE_SIZE aligned
+ * and 2 pages or more. The tail is used for the memory map of the region.
+ * @return int 0 on success, or negative errno value on failure.
+ */
+int register_region(void *addr, size_t size);
+
+void *__get_pages(size_t size);
+
+/**
+ * @brief Allocate physically contiguous pages.
+ *
+ * @return void* Start of the pages, or NULL if not available.
+ */
+static inline void *get_pages(size_t size) {
+  return __get_pages((size + PAGE_MASK) & ~PAGE_MASK);
+}
+
+/**
+ * @brief Return the pages from get_pages with the same size.
+ */
+void return_pages(void *p, size_t size);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PAGE_ALLOC_H */
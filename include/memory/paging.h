@@ -0,0 +1,90 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Page tables set up by <src/kernel.asm> before entering the higher half.
+ * Only large pages are used, so that no page table is needed
+ * below the page directory.
+ *
+ * - [0, PAGING_IDENTITY_LIMIT) is identity mapped, and holds all usable RAM.
+ * - [KERNEL_VIRTUAL_BASE, +KERNEL_VIRTUAL_SIZE) is mapped to physical 0,
+ *   which is where the kernel runs.
+ * - [PAGING_MMIO_BASE, 4G) is identity mapped without caching for MMIO.
+ *
+ * In 32 bit mode, a single page directory of 4 MiB pages covers everything.
+ * In long mode, the low 4G uses 2 MiB pages of four page directories,
+ * and the kernel is in the top 2G of the address space instead,
+ * as the kernel code model expects. Lower 32 bits of every kernel address
+ * are the same in both modes.
+ *
+ * These should match <src/kernel.asm> and <src/script.ld>.
+ */
+#ifdef CONFIG_X86_64
+#define KERNEL_VIRTUAL_BASE 0xFFFFFFFFC0000000UL
+#else
+#define KERNEL_VIRTUAL_BASE 0xC0000000UL
+#endif /* CONFIG_X86_64 */
+#define KERNEL_VIRTUAL_SIZE 0x10000000UL
+
+#define PAGING_IDENTITY_LIMIT 0xC0000000UL
+#define PAGING_MMIO_BASE 0xD0000000UL
+
+#ifdef CONFIG_X86_64
+#define PAGING_LARGE_PAGE_SHIFT 21
+#define PAGING_DIRECTORY_ENTRY_COUNT 512
+#else
+#define PAGING_LARGE_PAGE_SHIFT 22
+#define PAGING_DIRECTORY_ENTRY_COUNT 1024
+#endif /* CONFIG_X86_64 */
+#define PAGING_LARGE_PAGE_SIZE (1UL << PAGING_LARGE_PAGE_SHIFT)
+
+#define PAGING_PDE_PRESENT (1U << 0)
+#define PAGING_PDE_WRITE (1U << 1)
+#define PAGING_PDE_WRITE_THROUGH (1U << 3)
+#define PAGING_PDE_CACHE_DISABLE (1U << 4)
+#define PAGING_PDE_LARGE (1U << 7)
+#define PAGING_PDE_GLOBAL (1U << 8)
+
+#ifdef CONFIG_X86_64
+typedef uint64_t paging_entry_t;
+
+/* Top level table, whose physical address is loaded to CR3. */
+extern paging_entry_t kernel_pml4[PAGING_DIRECTORY_ENTRY_COUNT];
+#else
+typedef uint32_t paging_entry_t;
+
+extern paging_entry_t kernel_page_directory[PAGING_DIRECTORY_ENTRY_COUNT];
+#endif /* CONFIG_X86_64 */
+
+/**
+ * @brief Physical address of an object in the kernel image.
+ *
+ * This is for addresses the hardware should see, such as CR3.
+ */
+static inline uintptr_t kernel_virt_to_phys(const void *addr) {
+  return (uintptr_t)addr - KERNEL_VIRTUAL_BASE;
+}
+
+/**
+ * @brief Whether the physical address is in the uncached MMIO window.
+ *
+ * Device registers are accessed through their identity mapping, which
+ * should be uncached, since reads have side effects and writes should
+ * reach the device in order.
+ */
+static inline bool paging_mmio_mapped(uint64_t addr) {
+  return addr >= PAGING_MMIO_BASE && (addr >> 32) == 0;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PAGING_H */
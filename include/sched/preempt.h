@@ -0,0 +1,32 @@
+#ifndef PREEMPT_H
+#define PREEMPT_H
+
+#include <cpu/percpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Threads are only preempted on the processor while this is 0. */
+DECLARE_PER_CPU(unsigned int, preempt_count);
+
+/**
+ * @brief Keep the running thread on the processor until preempt_enable.
+ *
+ * Calls nest. Preemption held off meanwhile happens on the next interrupt.
+ */
+static inline void preempt_disable() {
+  this_cpu_inc(preempt_count);
+  __asm__ volatile("" : : : "memory");
+}
+
+static inline void preempt_enable() {
+  __asm__ volatile("" : : : "memory");
+  this_cpu_add(preempt_count, -1);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PREEMPT_H */
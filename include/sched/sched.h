@@ -0,0 +1,116 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+#include <base.h>
+#include <idt/irq.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Stack of each thread from the page allocator, which also holds the TCB. */
+#define THREAD_STACK_SIZE 0x4000
+
+/* Running thread is preempted after this long if another one is waiting. */
+#define SCHED_SLICE_NS 10000000U
+
+/* IPI which wakes up an idle processor to steal runnable threads. */
+#define SCHED_IPI_VECTOR 0xEE
+
+struct thread;
+
+/**
+ * Counters of a processor, only updated by the processor itself.
+ */
+struct sched_stats {
+  uint32_t switches;
+  /* Threads switched to which last ran on another processor. */
+  uint32_t migrations;
+  /* Times threads were stolen from another processor, and how many. */
+  uint32_t steals;
+  uint32_t stolen;
+  /* IPIs sent to wake up idle processors. */
+  uint32_t ipis;
+};
+
+typedef void (*thread_fn_t)(void *ctx);
+
+/**
+ * @brief Turn the flow of control of the calling processor into
+ * its idle thread, so that other threads can be switched to.
+ *
+ * This should be called on each processor, after timer_init.
+ */
+void sched_init();
+
+/**
+ * @brief Run threads on the calling processor, and halt while
+ * there is none to run. This never returns.
+ *
+ * This should be called by the thread set up by sched_init. Threads
+ * queued on other processors are stolen when this one runs out,
+ * and halted processors are sent an IPI when there are some to steal.
+ */
+NORETURN void sched_idle();
+
+/**
+ * @brief Preempt the interrupted thread if its slice is used up
+ * or it is the idle thread, and another thread is runnable.
+ *
+ * This is called by irq_dispatch after softirqs, and does nothing
+ * if the interrupted code had interrupts or preemption disabled.
+ */
+void sched_irq_exit(const struct trap_frame *frame);
+
+/**
+ * @brief Start a thread which calls fn(ctx) and exits when it returns.
+ *
+ * @return struct thread* The thread, which is no longer valid once
+ * it exits, or NULL if there is no memory for its stack.
+ */
+struct thread *thread_create(thread_fn_t fn, void *ctx);
+
+/**
+ * @brief Thread running on the calling processor.
+ */
+struct thread *thread_current();
+
+/**
+ * @brief Let other runnable threads run before the calling one continues.
+ */
+void thread_yield();
+
+/**
+ * @brief Sleep until ktime_get_ns reaches deadline_ns.
+ */
+void thread_sleep_until(uint64_t deadline_ns);
+
+/**
+ * @brief Make the sleeping thread runnable before its deadline, on the run
+ * queue of the calling processor. This does nothing if it is not sleeping.
+ */
+void thread_wake(struct thread *thread);
+
+/**
+ * @brief Exit the calling thread, whose stack is returned
+ * once another thread runs.
+ */
+NORETURN void thread_exit();
+
+/**
+ * @brief Copy the counters of the processor.
+ */
+void sched_get_stats(unsigned int cpu, struct sched_stats *stats);
+
+/**
+ * @brief Print the counters of each processor.
+ */
+void sched_stats_dump();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* SCHED_H */
@@ -0,0 +1,52 @@
+#ifndef STEAL_QUEUE_H
+#define STEAL_QUEUE_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Capacity of each queue, which should be a power of 2. */
+#define STEAL_QUEUE_SIZE 256U
+
+/**
+ * Lock free FIFO ring with a single producer and any number of consumers,
+ * with a fixed capacity.
+ *
+ * Only the owner pushes, at the tail, and anyone including the owner
+ * pops the oldest item from the head, so that other processors can steal
+ * items without a lock. Indices only grow, and wrap around safely
+ * since only their difference matters. A zero initialized queue is empty.
+ */
+struct steal_queue {
+  unsigned long head;
+  unsigned long tail;
+  void *items[STEAL_QUEUE_SIZE];
+};
+
+/**
+ * @brief Push an item at the tail. Only the owner may call this.
+ *
+ * @return int 0 on success, or -1 if the queue is full.
+ */
+int steal_queue_push(struct steal_queue *queue, void *item);
+
+/**
+ * @brief Pop the oldest item from the head, from any processor.
+ *
+ * @return void* The item, or NULL if the queue is empty or another
+ * processor got the item first.
+ */
+void *steal_queue_pop(struct steal_queue *queue);
+
+/**
+ * @brief Number of items, which may be stale by the time it is used.
+ */
+unsigned long steal_queue_size(const struct steal_queue *queue);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* STEAL_QUEUE_H */
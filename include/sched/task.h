@@ -0,0 +1,99 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Tasks are continuations which run to completion from SOFTIRQ_TASK,
+ * on the processor which queued them, in order of queueing.
+ * They are embedded in the object they work on, so nothing is allocated
+ * per task, and an operation which waits is a task parked on a future
+ * rather than a thread. Tasks should not sleep.
+ */
+struct task;
+
+typedef void (*task_fn_t)(struct task *task);
+
+struct task {
+  struct task *next;
+  task_fn_t fn;
+  bool queued;
+};
+
+#define TASK_INIT(task_fn) { .next = NULL, .fn = (task_fn), .queued = false }
+
+/**
+ * Result of an operation which completes later, typically from
+ * an interrupt handler, and the task to run once it does.
+ * A zero initialized future is pending without a continuation.
+ */
+struct future {
+  /* Continuation if any, with flags of the completion. */
+  uintptr_t state;
+  int result;
+};
+
+#define FUTURE_INIT { .state = 0, .result = 0 }
+
+/**
+ * @brief Register the softirq which runs tasks.
+ */
+void executor_init();
+
+void task_init(struct task *task, task_fn_t fn);
+
+/**
+ * @brief Queue the task on the calling processor.
+ *
+ * This is safe from any context, including interrupt handlers.
+ * Tasks queued by threads with interrupts enabled run before this returns,
+ * and the others on the way out of the interrupt or softirq.
+ * fn is called once however many times the task is queued before it runs,
+ * and it may queue the task again.
+ *
+ * @return bool false if the task is already queued.
+ */
+bool task_schedule(struct task *task);
+
+/**
+ * @brief Make the future pending again, so that it can be reused.
+ * This should not race with future_then or future_complete.
+ */
+void future_init(struct future *future);
+
+/**
+ * @brief Run the task once the future completes, right away if it has.
+ *
+ * A future has one continuation at a time, which may set another one
+ * on a reused future.
+ */
+void future_then(struct future *future, struct task *task);
+
+/**
+ * @brief Complete the future and queue its continuation on the calling
+ * processor. This is safe from interrupt handlers, and only the first
+ * of several completers gets to set the result.
+ *
+ * @return int 0 on success, -1 if the future was already completed.
+ */
+int future_complete(struct future *future, int result);
+
+bool future_done(const struct future *future);
+
+/**
+ * @brief Result passed to future_complete, which is only valid
+ * once the future is done.
+ */
+int future_result(const struct future *future);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* TASK_H */
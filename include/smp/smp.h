@@ -0,0 +1,48 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Application processors start in real mode at this page,
+ * where <src/smp/trampoline.asm> is copied to.
+ * It should be below 1M and page aligned. Memory below 1M is never handed
+ * to the page allocator, and stage 2 is not needed once the kernel runs.
+ *
+ * This should match <src/smp/trampoline.asm>.
+ */
+#define SMP_TRAMPOLINE_ADDR 0x8000
+
+/* Stack of each application processor, from the page allocator. */
+#define SMP_AP_STACK_SIZE 0x4000
+
+/**
+ * @brief Start every application processor described by the MADT.
+ *
+ * Processors are started one at a time, and each of them enters
+ * kernel_main_ap with its own stack before the next one is started.
+ * This should be called after memmap_init and idt_init.
+ *
+ * @return unsigned int Number of processors online, including this one.
+ */
+unsigned int smp_init();
+
+/**
+ * @brief Number of processors online.
+ */
+unsigned int smp_cpu_count();
+
+/**
+ * @brief APIC id of the processor, for sending it interrupts.
+ */
+uint32_t smp_cpu_apic_id(unsigned int cpu);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* SMP_H */
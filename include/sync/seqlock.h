@@ -0,0 +1,56 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Sequence counter for data which is read much more often than written.
+ * Readers never write to shared memory, and retry if a writer
+ * got in the way. Writers should be serialized by other means,
+ * and should run with interrupts disabled so that a reader
+ * on the same processor does not spin forever.
+ */
+struct seqlock {
+  uint32_t sequence;
+};
+
+#define SEQLOCK_INIT                                                           \
+  { .sequence = 0 }
+
+static inline uint32_t read_seqbegin(const struct seqlock *lock) {
+  uint32_t sequence;
+
+  /* Odd sequence means a writer is in the middle of an update. */
+  while ((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 1)
+    x86_pause();
+
+  return sequence;
+}
+
+static inline bool read_seqretry(const struct seqlock *lock,
+                                 uint32_t sequence) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+static inline void write_seqbegin(struct seqlock *lock) {
+  __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_seqend(struct seqlock *lock) {
+  __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* SEQLOCK_H */
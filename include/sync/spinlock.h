@@ -0,0 +1,54 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct spinlock {
+  uint32_t locked;
+};
+
+#define SPINLOCK_INIT                                                          \
+  { .locked = 0 }
+
+static inline void spin_lock(struct spinlock *lock) {
+  /* Spin on plain loads, so that the cache line is not bounced around. */
+  while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE)) {
+    while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED))
+      x86_pause();
+  }
+}
+
+static inline void spin_unlock(struct spinlock *lock) {
+  __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Take the lock with interrupts disabled.
+ *
+ * This should be used for locks also taken by interrupt handlers,
+ * so that the handler does not spin on the lock its own processor holds.
+ */
+static inline unsigned long spin_lock_irqsave(struct spinlock *lock) {
+  unsigned long flags = x86_irq_save();
+
+  spin_lock(lock);
+  return flags;
+}
+
+static inline void spin_unlock_irqrestore(struct spinlock *lock,
+                                          unsigned long flags) {
+  spin_unlock(lock);
+  x86_irq_restore(flags);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* SPINLOCK_H */
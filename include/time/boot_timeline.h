@@ -0,0 +1,29 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <boot/bootinfo.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Collect the checkpoints stamped before kernel_main.
+ *
+ * This should be called after boot_info_init,
+ * but before any other checkpoint is stamped.
+ */
+void boot_timeline_init();
+
+void boot_timeline_stamp(enum boot_phase phase);
+
+/**
+ * @brief Print the time spent before reaching each checkpoint.
+ */
+void boot_timeline_print();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* BOOT_TIMELINE_H */
@@ -0,0 +1,58 @@
+#ifndef CLOCKEVENT_H
+#define CLOCKEVENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Vector of the local APIC timer, below the spurious vector. */
+#define CLOCKEVENT_LAPIC_VECTOR 0xEF
+
+/**
+ * @brief Pick the timer which raises events on the bootstrap processor.
+ *
+ * This prefers the local APIC timer in TSC-deadline mode, then the local
+ * APIC timer in one-shot mode, then channel 0 of the PIT. Every timer
+ * runs in one-shot mode, so there are no interrupts unless an event
+ * is programmed. This should be called after ktime_init and idt_init.
+ *
+ * @return int 0 on success, or -1 if there is no usable timer.
+ */
+int clockevent_init();
+
+/**
+ * @brief Set up the timer of an application processor.
+ *
+ * Only the local APIC timers are per processor, so application
+ * processors get no events when the PIT is in use.
+ */
+void clockevent_init_ap();
+
+/**
+ * @brief Whether each processor raises its own events, which timers
+ * on application processors rely on. This is false with the PIT.
+ */
+bool clockevent_per_cpu();
+
+/**
+ * @brief Raise SOFTIRQ_TIMER on the calling processor once ktime_get_ns
+ * reaches deadline_ns, replacing the event programmed before.
+ *
+ * A deadline in the past raises it right away. Deadlines beyond the range
+ * of the timer are reached in several steps, without waking up softirqs.
+ */
+void clockevent_program(uint64_t deadline_ns);
+
+/**
+ * @brief Cancel the event programmed on the calling processor.
+ */
+void clockevent_cancel();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* CLOCKEVENT_H */
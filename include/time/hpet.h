@@ -0,0 +1,55 @@
+#ifndef HPET_H
+#define HPET_H
+
+#include <stdint.h>
+
+#include <acpi/acpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define HPET_SIGNATURE "HPET"
+
+#define ACPI_ADDRESS_SPACE_MEMORY 0
+
+struct __attribute__((packed)) acpi_generic_address {
+  uint8_t space_id;
+  uint8_t bit_width;
+  uint8_t bit_offset;
+  uint8_t access_size;
+  uint64_t address;
+};
+
+struct __attribute__((packed)) acpi_hpet {
+  struct acpi_sdt_header header;
+  uint32_t event_timer_block_id;
+  struct acpi_generic_address address;
+  uint8_t hpet_number;
+  uint16_t minimum_tick;
+  uint8_t page_protection;
+};
+
+/**
+ * @brief Find the HPET in the ACPI tables and start its main counter.
+ *
+ * @return int 0 on success, or -1 if there is no usable HPET.
+ */
+int hpet_init();
+
+/**
+ * @brief Period of the main counter in femtoseconds.
+ */
+uint32_t hpet_period_fs();
+
+/**
+ * @brief Read the low 32 bits of the main counter, which is all
+ * every HPET has. It wraps after a few minutes at the slowest rate.
+ */
+uint32_t hpet_read_counter();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* HPET_H */
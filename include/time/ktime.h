@@ -0,0 +1,53 @@
+#ifndef KTIME_H
+#define KTIME_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define NSEC_PER_USEC 1000U
+#define NSEC_PER_MSEC 1000000U
+#define NSEC_PER_SEC 1000000000U
+
+/**
+ * @brief Calibrate the time stamp counter, which ktime is built on.
+ *
+ * This should be called with interrupts disabled, after acpi_init
+ * so that the HPET can be used.
+ *
+ * @return int 0 on success, or -1 if the calibration failed.
+ */
+int ktime_init();
+
+/**
+ * @brief Monotonic time in nanoseconds since the processor was reset.
+ *
+ * This is lock free and does no port I/O, so it can be called from
+ * any context. Time stamp counters of all processors are assumed
+ * to be in sync. It is 0 until ktime_init succeeds.
+ */
+uint64_t ktime_get_ns();
+
+/**
+ * @brief Convert a duration in time stamp counter cycles to nanoseconds.
+ */
+uint64_t ktime_cycles_to_ns(uint64_t cycles);
+
+/**
+ * @brief Rate of the time stamp counter in kHz, or 0 before ktime_init.
+ */
+uint32_t ktime_tsc_khz();
+
+/**
+ * @brief Change the rate of the time stamp counter, for example after
+ * a finer calibration. Time stays continuous across the change.
+ */
+void ktime_set_tsc_khz(uint32_t tsc_khz);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* KTIME_H */
@@ -0,0 +1,42 @@
+#ifndef PIT_H
+#define PIT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define PIT_FREQUENCY_HZ 1193182U
+
+/**
+ * @brief Busy wait with channel 2 of the 8254 PIT.
+ *
+ * Channel 0 is left alone, since it drives the timer interrupt.
+ * This does not depend on interrupts, so that it can be used
+ * before any timer is set up.
+ */
+void pit_delay_us(uint32_t us);
+
+/**
+ * @brief Same as pit_delay_us in PIT_FREQUENCY_HZ ticks,
+ * for callers which want the exact length of the delay.
+ */
+void pit_delay_ticks(uint16_t ticks);
+
+/**
+ * @brief Raise the timer interrupt once after ticks of channel 0,
+ * replacing the periodic interrupt set up by the firmware.
+ */
+void pit_oneshot(uint16_t ticks);
+
+/**
+ * @brief Stop channel 0, so that it raises no more timer interrupts.
+ */
+void pit_stop();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PIT_H */
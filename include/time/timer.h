@@ -0,0 +1,85 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct timer_wheel;
+
+typedef void (*timer_fn_t)(void *ctx);
+
+/**
+ * Timeout which calls fn once ktime_get_ns reaches the deadline.
+ * A zero initialized timer is not pending. Fields are owned by
+ * the wheel the timer is on, and should only be touched through
+ * the functions below.
+ */
+struct timer {
+  struct timer *next;
+  /* Link pointing to this timer, so that it is unlinked in O(1). */
+  struct timer **pprev;
+  /* Wheel the timer is pending on, or NULL. */
+  struct timer_wheel *wheel;
+  /* Wheel the timer was last added to, whose callback may be running. */
+  struct timer_wheel *last_wheel;
+  /* Tick the timer expires at. */
+  uint64_t expires;
+  timer_fn_t fn;
+  void *ctx;
+};
+
+/**
+ * @brief Run expired timers from SOFTIRQ_TIMER.
+ *
+ * This should be called before any timer is added.
+ */
+void timer_init();
+
+/**
+ * @brief Call fn(ctx) on the calling processor once ktime_get_ns reaches
+ * deadline_ns, replacing the previous deadline if the timer is pending.
+ *
+ * This is O(1), and may be called from any context including fn itself.
+ * The same timer should not be added from two processors at once,
+ * and application processors should only add timers if
+ * clockevent_per_cpu, since they get no events otherwise.
+ * Timers expire in batches in SOFTIRQ_TIMER, up to about a millisecond
+ * after the deadline, and never before it.
+ */
+void timer_add(struct timer *timer, uint64_t deadline_ns, timer_fn_t fn,
+               void *ctx);
+
+/**
+ * @brief Remove the timer if it is pending, in O(1).
+ *
+ * This does not wait for fn if it is already running on another processor.
+ *
+ * @return bool true if the timer was pending.
+ */
+bool timer_cancel(struct timer *timer);
+
+/**
+ * @brief Remove the timer like timer_cancel, and wait for fn
+ * if it is running on another processor, so that the timer
+ * can be freed right after.
+ *
+ * This should not be called from fn, or from softirqs.
+ *
+ * @return bool true if the timer was pending.
+ */
+bool timer_cancel_sync(struct timer *timer);
+
+/**
+ * @brief Whether the timer is waiting to expire.
+ */
+bool timer_pending(const struct timer *timer);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* TIMER_H */
@@ -0,0 +1,32 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @brief Whether the time stamp counter runs at a constant rate
+ * regardless of power states.
+ */
+bool tsc_invariant();
+
+/**
+ * @brief Measure the rate of the time stamp counter against the HPET,
+ * or the PIT if there is no HPET.
+ *
+ * This busy waits for a few tens of milliseconds, and should be called
+ * with interrupts disabled.
+ *
+ * @return uint32_t Rate in kHz, or 0 if the measurement failed.
+ */
+uint32_t tsc_calibrate();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* TSC_H */
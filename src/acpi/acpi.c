@@ -0,0 +1,105 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <acpi/acpi.h>
+#include <memory/memory.h>
+#include <memory/paging.h>
+
+/* Segment of the extended BIOS data area is stored in the BIOS data area. */
+#define ACPI_BDA_EBDA_SEGMENT_ADDR 0x40E
+#define ACPI_EBDA_SEARCH_SIZE 0x400
+
+#define ACPI_BIOS_AREA_START 0xE0000
+#define ACPI_BIOS_AREA_END 0x100000
+
+#define ACPI_RSDP_ALIGN 16
+
+static const struct acpi_sdt_header *acpi_rsdt;
+
+static uint8_t acpi_checksum(const void *addr, uint32_t size) {
+  const uint8_t *cur = (const uint8_t *)addr;
+  uint8_t sum = 0;
+
+  while (size-- > 0)
+    sum += *cur++;
+
+  return sum;
+}
+
+static const struct acpi_rsdp *acpi_scan_rsdp(uintptr_t start, uintptr_t end) {
+  for (uintptr_t addr = start; addr + ACPI_RSDP_V1_SIZE <= end;
+       addr += ACPI_RSDP_ALIGN) {
+    const struct acpi_rsdp *rsdp = (const struct acpi_rsdp *)addr;
+
+    if (!kmemcmp(rsdp->signature, ACPI_RSDP_SIGNATURE,
+                 ACPI_RSDP_SIGNATURE_SIZE) &&
+        acpi_checksum(rsdp, ACPI_RSDP_V1_SIZE) == 0)
+      return rsdp;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Tables are accessed through the identity map,
+ * so anything outside of it cannot be used.
+ */
+static const struct acpi_sdt_header *acpi_map_table(uint32_t addr) {
+  const struct acpi_sdt_header *header;
+
+  if (addr == 0 || addr >= PAGING_IDENTITY_LIMIT - sizeof(*header))
+    return NULL;
+
+  header = (const struct acpi_sdt_header *)(uintptr_t)addr;
+  if (header->length < sizeof(*header) ||
+      header->length > PAGING_IDENTITY_LIMIT - addr ||
+      acpi_checksum(header, header->length) != 0)
+    return NULL;
+
+  return header;
+}
+
+int acpi_init() {
+  const volatile uint16_t *ebda_segment =
+      (const volatile uint16_t *)ACPI_BDA_EBDA_SEGMENT_ADDR;
+  const uintptr_t ebda = (uintptr_t)*ebda_segment << 4;
+  const struct acpi_rsdp *rsdp = NULL;
+
+  if (ebda != 0)
+    rsdp = acpi_scan_rsdp(ebda, ebda + ACPI_EBDA_SEARCH_SIZE);
+  if (rsdp == NULL)
+    rsdp = acpi_scan_rsdp(ACPI_BIOS_AREA_START, ACPI_BIOS_AREA_END);
+  if (rsdp == NULL)
+    return -1;
+
+  /**
+   * XSDT is not used, since the tables it points to
+   * should be reachable from RSDT as well on 32 bit machines.
+   */
+  acpi_rsdt = acpi_map_table(rsdp->rsdt_addr);
+  if (acpi_rsdt == NULL)
+    return -1;
+
+  return 0;
+}
+
+const struct acpi_sdt_header *acpi_find_table(const char *signature) {
+  const uint32_t *entries;
+  uint32_t count;
+
+  if (acpi_rsdt == NULL)
+    return NULL;
+
+  entries = (const uint32_t *)(acpi_rsdt + 1);
+  count = (acpi_rsdt->length - sizeof(*acpi_rsdt)) / sizeof(*entries);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const struct acpi_sdt_header *header = acpi_map_table(entries[i]);
+
+    if (header != NULL &&
+        !kmemcmp(header->signature, signature, ACPI_SDT_SIGNATURE_SIZE))
+      return header;
+  }
+
+  return NULL;
+}
@@ -0,0 +1,112 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <acpi/acpi.h>
+#include <acpi/madt.h>
+#include <config.h>
+#include <display/display.h>
+
+static struct madt_info madt_info_data;
+static bool madt_valid;
+
+static void madt_add_cpu(uint32_t apic_id, uint32_t flags) {
+  /* Processors which may be hotplugged later are not supported. */
+  if (!(flags & MADT_LOCAL_APIC_ENABLED))
+    return;
+
+  if (madt_info_data.cpu_count == CONFIG_MAX_CPUS) {
+    terminal_printk("MADT: ignoring processor with APIC id %u\n",
+                    (unsigned int)apic_id);
+    return;
+  }
+
+  madt_info_data.cpu_apic_ids[madt_info_data.cpu_count++] = apic_id;
+}
+
+static void madt_add_io_apic(const struct madt_io_apic *entry) {
+  struct madt_io_apic_info *info;
+
+  if (madt_info_data.io_apic_count == MADT_IO_APIC_MAX) {
+    terminal_printk("MADT: ignoring I/O APIC with id %u\n",
+                    (unsigned int)entry->io_apic_id);
+    return;
+  }
+
+  info = &madt_info_data.io_apics[madt_info_data.io_apic_count++];
+  info->id = entry->io_apic_id;
+  info->addr = entry->io_apic_addr;
+  info->gsi_base = entry->gsi_base;
+}
+
+static void madt_add_override(const struct madt_interrupt_override *entry) {
+  /* Only ISA overrides are defined. */
+  if (entry->bus != 0 || entry->source >= MADT_ISA_IRQ_COUNT)
+    return;
+
+  madt_info_data.isa_irqs[entry->source].gsi = entry->gsi;
+  madt_info_data.isa_irqs[entry->source].flags = entry->flags;
+}
+
+int madt_init() {
+  const struct madt *madt =
+      (const struct madt *)acpi_find_table(MADT_SIGNATURE);
+  const uint8_t *cur, *end;
+
+  if (madt == NULL || madt->header.length < sizeof(*madt))
+    return -1;
+
+  madt_info_data.cpu_count = 0;
+  madt_info_data.io_apic_count = 0;
+  for (uint32_t irq = 0; irq < MADT_ISA_IRQ_COUNT; ++irq) {
+    madt_info_data.isa_irqs[irq].gsi = irq;
+    madt_info_data.isa_irqs[irq].flags = 0;
+  }
+
+  cur = (const uint8_t *)(madt + 1);
+  end = (const uint8_t *)madt + madt->header.length;
+
+  while (cur + sizeof(struct madt_entry_header) <= end) {
+    const struct madt_entry_header *header =
+        (const struct madt_entry_header *)cur;
+
+    if (header->length < sizeof(*header) || cur + header->length > end)
+      break;
+
+    switch (header->type) {
+    case MADT_ENTRY_LOCAL_APIC:
+      if (header->length >= sizeof(struct madt_local_apic)) {
+        const struct madt_local_apic *entry =
+            (const struct madt_local_apic *)header;
+        madt_add_cpu(entry->apic_id, entry->flags);
+      }
+      break;
+    case MADT_ENTRY_LOCAL_X2APIC:
+      if (header->length >= sizeof(struct madt_local_x2apic)) {
+        const struct madt_local_x2apic *entry =
+            (const struct madt_local_x2apic *)header;
+        madt_add_cpu(entry->x2apic_id, entry->flags);
+      }
+      break;
+    case MADT_ENTRY_IO_APIC:
+      if (header->length >= sizeof(struct madt_io_apic))
+        madt_add_io_apic((const struct madt_io_apic *)header);
+      break;
+    case MADT_ENTRY_INTERRUPT_OVERRIDE:
+      if (header->length >= sizeof(struct madt_interrupt_override))
+        madt_add_override((const struct madt_interrupt_override *)header);
+      break;
+    default:
+      break;
+    }
+
+    cur += header->length;
+  }
+
+  madt_valid = true;
+  return 0;
+}
+
+const struct madt_info *madt_get() {
+  return madt_valid ? &madt_info_data : NULL;
+}
@@ -0,0 +1,149 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <acpi/madt.h>
+#include <apic/ioapic.h>
+#include <display/display.h>
+#include <memory/paging.h>
+#include <sync/spinlock.h>
+
+/* Registers are accessed by writing the index, then the window. */
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+
+#define IOAPIC_REG_VERSION 0x01
+#define IOAPIC_REG_REDIRECTION_BASE 0x10
+
+#define IOAPIC_VERSION_MAX_ENTRY_SHIFT 16
+#define IOAPIC_VERSION_MAX_ENTRY_MASK 0xFFU
+
+/* Delivery mode is fixed and destination mode is physical when zero. */
+#define IOAPIC_REDIRECTION_ACTIVE_LOW (1U << 13)
+#define IOAPIC_REDIRECTION_LEVEL (1U << 15)
+#define IOAPIC_REDIRECTION_MASKED (1U << 16)
+#define IOAPIC_REDIRECTION_DEST_SHIFT 24
+
+struct ioapic {
+  volatile uint32_t *base;
+  uint32_t gsi_base;
+  uint32_t entry_count;
+  struct spinlock lock;
+};
+
+static struct ioapic ioapics[MADT_IO_APIC_MAX];
+static unsigned int ioapic_count;
+
+static uint32_t ioapic_read(struct ioapic *ioapic, uint32_t reg) {
+  ioapic->base[IOAPIC_REGSEL / sizeof(*ioapic->base)] = reg;
+  return ioapic->base[IOAPIC_WINDOW / sizeof(*ioapic->base)];
+}
+
+static void ioapic_write(struct ioapic *ioapic, uint32_t reg,
+                         uint32_t value) {
+  ioapic->base[IOAPIC_REGSEL / sizeof(*ioapic->base)] = reg;
+  ioapic->base[IOAPIC_WINDOW / sizeof(*ioapic->base)] = value;
+}
+
+static struct ioapic *ioapic_find(uint32_t gsi) {
+  for (unsigned int i = 0; i < ioapic_count; ++i) {
+    struct ioapic *ioapic = &ioapics[i];
+
+    if (gsi >= ioapic->gsi_base &&
+        gsi - ioapic->gsi_base < ioapic->entry_count)
+      return ioapic;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Write a redirection entry, with the low half last
+ * so that the entry is not unmasked with a stale destination.
+ */
+static void ioapic_set_entry(struct ioapic *ioapic, uint32_t index,
+                             uint32_t lo, uint32_t hi) {
+  const uint32_t reg = IOAPIC_REG_REDIRECTION_BASE + index * 2;
+  unsigned long flags = spin_lock_irqsave(&ioapic->lock);
+
+  ioapic_write(ioapic, reg, IOAPIC_REDIRECTION_MASKED);
+  ioapic_write(ioapic, reg + 1, hi);
+  ioapic_write(ioapic, reg, lo);
+
+  spin_unlock_irqrestore(&ioapic->lock, flags);
+}
+
+int ioapic_init() {
+  const struct madt_info *madt = madt_get();
+
+  if (madt == NULL)
+    return -1;
+
+  ioapic_count = 0;
+  for (uint32_t i = 0; i < madt->io_apic_count; ++i) {
+    const struct madt_io_apic_info *info = &madt->io_apics[i];
+    struct ioapic *ioapic = &ioapics[ioapic_count];
+
+    if (!paging_mmio_mapped(info->addr)) {
+      terminal_printk("I/O APIC %u at %08x is not mapped\n",
+                      (unsigned int)info->id, (unsigned int)info->addr);
+      continue;
+    }
+
+    ioapic->base = (volatile uint32_t *)(uintptr_t)info->addr;
+    ioapic->gsi_base = info->gsi_base;
+    ioapic->entry_count = ((ioapic_read(ioapic, IOAPIC_REG_VERSION) >>
+                            IOAPIC_VERSION_MAX_ENTRY_SHIFT) &
+                           IOAPIC_VERSION_MAX_ENTRY_MASK) +
+                          1;
+    ioapic->lock = (struct spinlock)SPINLOCK_INIT;
+
+    for (uint32_t index = 0; index < ioapic->entry_count; ++index)
+      ioapic_set_entry(ioapic, index, IOAPIC_REDIRECTION_MASKED, 0);
+
+    ioapic_count++;
+  }
+
+  return ioapic_count > 0 ? 0 : -1;
+}
+
+int ioapic_route_gsi(uint32_t gsi, uint8_t vector, uint32_t apic_id,
+                     bool level_triggered, bool active_low) {
+  struct ioapic *ioapic = ioapic_find(gsi);
+  uint32_t lo = vector;
+
+  if (ioapic == NULL)
+    return -1;
+
+  if (level_triggered)
+    lo |= IOAPIC_REDIRECTION_LEVEL;
+  if (active_low)
+    lo |= IOAPIC_REDIRECTION_ACTIVE_LOW;
+
+  ioapic_set_entry(ioapic, gsi - ioapic->gsi_base, lo,
+                   apic_id << IOAPIC_REDIRECTION_DEST_SHIFT);
+  return 0;
+}
+
+int ioapic_route_isa_irq(unsigned int irq, uint8_t vector, uint32_t apic_id) {
+  const struct madt_info *madt = madt_get();
+  const struct madt_isa_irq_info *info;
+
+  if (madt == NULL || irq >= MADT_ISA_IRQ_COUNT)
+    return -1;
+
+  /* ISA interrupts are edge triggered and active high by default. */
+  info = &madt->isa_irqs[irq];
+  return ioapic_route_gsi(
+      info->gsi, vector, apic_id,
+      (info->flags & MADT_IRQ_TRIGGER_MASK) == MADT_IRQ_TRIGGER_LEVEL,
+      (info->flags & MADT_IRQ_POLARITY_MASK) == MADT_IRQ_POLARITY_ACTIVE_LOW);
+}
+
+void ioapic_mask_gsi(uint32_t gsi) {
+  struct ioapic *ioapic = ioapic_find(gsi);
+
+  if (ioapic != NULL)
+    ioapic_set_entry(ioapic, gsi - ioapic->gsi_base,
+                     IOAPIC_REDIRECTION_MASKED, 0);
+}
@@ -0,0 +1,204 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <apic/lapic.h>
+#include <cpu/cpu.h>
+#include <memory/paging.h>
+
+#define LAPIC_REG_ID 0x020
+#define LAPIC_REG_TPR 0x080
+#define LAPIC_REG_EOI 0x0B0
+#define LAPIC_REG_SVR 0x0F0
+#define LAPIC_REG_ICR_LO 0x300
+#define LAPIC_REG_ICR_HI 0x310
+#define LAPIC_REG_LVT_TIMER 0x320
+#define LAPIC_REG_TIMER_INITIAL 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE 0x3E0
+
+#define LAPIC_ID_SHIFT 24
+
+#define LAPIC_SVR_ENABLE (1U << 8)
+
+#define LAPIC_ICR_DELIVERY_FIXED (0U << 8)
+#define LAPIC_ICR_DELIVERY_INIT (5U << 8)
+#define LAPIC_ICR_DELIVERY_STARTUP (6U << 8)
+#define LAPIC_ICR_PENDING (1U << 12)
+#define LAPIC_ICR_ASSERT (1U << 14)
+#define LAPIC_ICR_TRIGGER_LEVEL (1U << 15)
+#define LAPIC_ICR_DEST_SHIFT 24
+
+#define LAPIC_LVT_MASKED (1U << 16)
+#define LAPIC_LVT_TIMER_ONESHOT (0U << 17)
+#define LAPIC_LVT_TIMER_TSC_DEADLINE (2U << 17)
+
+/* Timer counts down at the bus clock divided by 16. */
+#define LAPIC_TIMER_DIVIDE_16 0x3
+
+/**
+ * In x2APIC mode, each register is an MSR at this base plus
+ * the MMIO offset divided by 16. ICR is a single 64 bit MSR.
+ */
+#define X2APIC_MSR_BASE 0x800
+#define X2APIC_ICR_DEST_SHIFT 32
+
+#define X86_APIC_BASE_X2APIC_ENABLE (1U << 10)
+#define X86_APIC_BASE_ENABLE (1U << 11)
+#define X86_APIC_BASE_ADDR_MASK 0xFFFFF000U
+
+#define X86_MSR_TSC_DEADLINE 0x6E0
+
+static volatile uint32_t *lapic_base;
+
+/* Registers are accessed through MSRs instead of MMIO when set. */
+static bool lapic_x2apic;
+
+static inline uint32_t x2apic_msr(uint32_t reg) {
+  return X2APIC_MSR_BASE + (reg >> 4);
+}
+
+static inline uint32_t lapic_read(uint32_t reg) {
+  if (lapic_x2apic)
+    return (uint32_t)x86_rdmsr(x2apic_msr(reg));
+  return lapic_base[reg / sizeof(*lapic_base)];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+  if (lapic_x2apic)
+    x86_wrmsr(x2apic_msr(reg), value);
+  else
+    lapic_base[reg / sizeof(*lapic_base)] = value;
+}
+
+static void lapic_send_ipi(uint32_t apic_id, uint32_t command) {
+  /* There is no delivery status in x2APIC mode, so it does not wait. */
+  if (lapic_x2apic) {
+    /**
+     * Writes to x2APIC registers are not serializing, so the IPI could
+     * otherwise overtake stores the target is woken up to see.
+     */
+    __asm__ inline volatile("mfence; lfence" : : : "memory");
+    x86_wrmsr(x2apic_msr(LAPIC_REG_ICR_LO),
+              ((uint64_t)apic_id << X2APIC_ICR_DEST_SHIFT) | command);
+    return;
+  }
+
+  /* Writing the low half sends the IPI, so the destination goes first. */
+  lapic_write(LAPIC_REG_ICR_HI, apic_id << LAPIC_ICR_DEST_SHIFT);
+  lapic_write(LAPIC_REG_ICR_LO, command);
+
+  while (lapic_read(LAPIC_REG_ICR_LO) & LAPIC_ICR_PENDING)
+    x86_pause();
+}
+
+/**
+ * @brief Switch the local APIC of the calling processor to x2APIC mode.
+ *
+ * Processors come out of INIT in xAPIC mode, so each one does this.
+ */
+static void x2apic_enable() {
+  uint64_t apic_base = x86_rdmsr(X86_MSR_APIC_BASE);
+
+  if (!(apic_base & X86_APIC_BASE_X2APIC_ENABLE))
+    x86_wrmsr(X86_MSR_APIC_BASE, apic_base | X86_APIC_BASE_ENABLE |
+                                     X86_APIC_BASE_X2APIC_ENABLE);
+}
+
+int lapic_init() {
+  uint32_t eax, ebx, ecx, edx;
+  uint64_t apic_base;
+
+  x86_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+  if (!(edx & X86_CPUID_FEATURE_EDX_APIC) ||
+      !(edx & X86_CPUID_FEATURE_EDX_MSR))
+    return -1;
+
+  apic_base = x86_rdmsr(X86_MSR_APIC_BASE);
+  if (!(apic_base & X86_APIC_BASE_ENABLE))
+    return -1;
+
+  if (ecx & X86_CPUID_FEATURE_ECX_X2APIC) {
+    x2apic_enable();
+    lapic_x2apic = true;
+    return 0;
+  }
+
+  if (!paging_mmio_mapped(apic_base & X86_APIC_BASE_ADDR_MASK))
+    return -1;
+
+  lapic_base = (volatile uint32_t *)(uintptr_t)(apic_base &
+                                                X86_APIC_BASE_ADDR_MASK);
+  return 0;
+}
+
+void lapic_enable() {
+  if (lapic_x2apic)
+    x2apic_enable();
+
+  lapic_write(LAPIC_REG_TPR, 0);
+  lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+void lapic_eoi() { lapic_write(LAPIC_REG_EOI, 0); }
+
+uint32_t lapic_id() {
+  /* x2APIC id takes the whole register. */
+  if (lapic_x2apic)
+    return lapic_read(LAPIC_REG_ID);
+  return lapic_read(LAPIC_REG_ID) >> LAPIC_ID_SHIFT;
+}
+
+void lapic_send_init(uint32_t apic_id) {
+  lapic_send_ipi(apic_id, LAPIC_ICR_DELIVERY_INIT | LAPIC_ICR_TRIGGER_LEVEL |
+                              LAPIC_ICR_ASSERT);
+  /* Older processors also expect the deassert, which x2APIC does not have. */
+  if (!lapic_x2apic)
+    lapic_send_ipi(apic_id, LAPIC_ICR_DELIVERY_INIT | LAPIC_ICR_TRIGGER_LEVEL);
+}
+
+void lapic_send_startup(uint32_t apic_id, uint8_t vector) {
+  lapic_send_ipi(apic_id, LAPIC_ICR_DELIVERY_STARTUP | vector);
+}
+
+void lapic_send_fixed(uint32_t apic_id, uint8_t vector) {
+  lapic_send_ipi(apic_id, LAPIC_ICR_DELIVERY_FIXED | LAPIC_ICR_ASSERT | vector);
+}
+
+bool lapic_x2apic_enabled() { return lapic_x2apic; }
+
+bool lapic_tsc_deadline_supported() {
+  uint32_t eax, ebx, ecx, edx;
+
+  x86_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+  return ecx & X86_CPUID_FEATURE_ECX_TSC_DEADLINE;
+}
+
+void lapic_timer_init(uint8_t vector, bool tsc_deadline) {
+  lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+  lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+
+  if (!tsc_deadline) {
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_TIMER_ONESHOT | vector);
+    return;
+  }
+
+  x86_wrmsr(X86_MSR_TSC_DEADLINE, 0);
+  lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_TIMER_TSC_DEADLINE | vector);
+  /* Deadline should not be written before the mode switch is seen. */
+  __asm__ inline volatile("mfence" : : : "memory");
+}
+
+void lapic_timer_arm(uint32_t count) {
+  lapic_write(LAPIC_REG_TIMER_INITIAL, count);
+}
+
+void lapic_timer_arm_deadline(uint64_t tsc) {
+  x86_wrmsr(X86_MSR_TSC_DEADLINE, tsc);
+}
+
+uint32_t lapic_timer_count() { return lapic_read(LAPIC_REG_TIMER_CURRENT); }
+
+void lapic_timer_stop() {
+  lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+  lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+}
@@ -0,0 +1,287 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boot/ata.h>
+#include <boot/pci.h>
+#include <io/io.h>
+
+#define ATA_PRIMARY_IO_PORT 0x1F0
+#define ATA_PRIMARY_CONTROL_PORT 0x3F6
+
+#define ATA_REG_DATA 0x00
+#define ATA_REG_SECTOR_COUNT 0x02
+#define ATA_REG_LBA_LO 0x03
+#define ATA_REG_LBA_MID 0x04
+#define ATA_REG_LBA_HI 0x05
+#define ATA_REG_DEVICE 0x06
+#define ATA_REG_STATUS 0x07
+#define ATA_REG_COMMAND 0x07
+
+#define ATA_STATUS_ERR 0x01
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_DF 0x20
+#define ATA_STATUS_BSY 0x80
+
+#define ATA_CONTROL_NIEN 0x02
+
+#define ATA_DEVICE_MASTER_LBA 0x40
+
+#define ATA_COMMAND_READ_SECTORS_EXT 0x24
+#define ATA_COMMAND_READ_DMA_EXT 0x25
+#define ATA_COMMAND_READ_MULTIPLE_EXT 0x29
+#define ATA_COMMAND_SET_MULTIPLE_MODE 0xC6
+
+#define ATA_MULTIPLE_BLOCK_SECTORS 16
+
+/* Sector count of 0 stands for 0x10000 sectors in LBA48. */
+#define ATA_LBA48_MAX_SECTORS 0x10000
+
+#define IDE_BM_REG_COMMAND 0x00
+#define IDE_BM_REG_STATUS 0x02
+#define IDE_BM_REG_PRDT 0x04
+
+#define IDE_BM_COMMAND_START 0x01
+#define IDE_BM_COMMAND_READ 0x08
+
+#define IDE_BM_STATUS_ACTIVE 0x01
+#define IDE_BM_STATUS_ERROR 0x02
+#define IDE_BM_STATUS_INTERRUPT 0x04
+
+#define IDE_PROGIF_PRIMARY_NATIVE 0x01
+#define IDE_PROGIF_BUS_MASTER 0x80
+
+#define IDE_PRD_COUNT 128
+#define IDE_PRD_MAX_SIZE 0x10000
+#define IDE_PRD_END_OF_TABLE 0x8000
+
+/**
+ * A region described by a PRD must not cross 64K boundary,
+ * so a transfer that starts in the middle of a 64K window
+ * may need one more entry than its size suggests.
+ */
+#define IDE_DMA_MAX_SECTORS                                                    \
+  ((IDE_PRD_COUNT - 1) * (IDE_PRD_MAX_SIZE / ATA_SECTOR_SIZE))
+
+struct __attribute__((packed)) ide_prd {
+  uint32_t addr;
+  uint16_t size;
+  uint16_t flags;
+};
+
+/**
+ * The table should not cross 64K boundary,
+ * which holds since stage 2 as a whole is placed below 64K.
+ */
+static struct ide_prd ide_prdt[IDE_PRD_COUNT]
+    __attribute__((aligned(sizeof(struct ide_prd))));
+
+static struct {
+  uint8_t read_command;
+  uint8_t block_sectors;
+  /* Bus master IDE port base, or 0 if DMA is not available. */
+  uint16_t bm_port;
+} ata_state = {
+    .read_command = ATA_COMMAND_READ_SECTORS_EXT,
+    .block_sectors = 1,
+    .bm_port = 0,
+};
+
+static inline uint8_t ata_status() {
+  return x86_inb(ATA_PRIMARY_IO_PORT + ATA_REG_STATUS);
+}
+
+static inline uint8_t ata_wait_not_busy() {
+  uint8_t status;
+
+  /* Reading alternate status several times gives the drive 400ns to settle. */
+  for (int i = 0; i < 4; ++i)
+    x86_inb(ATA_PRIMARY_CONTROL_PORT);
+
+  do {
+    status = ata_status();
+  } while (status & ATA_STATUS_BSY);
+
+  return status;
+}
+
+static void ata_send_lba48(uint32_t lba, uint32_t nsector, uint8_t command) {
+  uint16_t count = (uint16_t)nsector;
+
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_DEVICE, ATA_DEVICE_MASTER_LBA);
+
+  /* Send high order bytes first, since registers are 2 byte FIFOs. */
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_SECTOR_COUNT, (uint8_t)(count >> 8));
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_LBA_LO, (uint8_t)(lba >> 24));
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_LBA_MID, 0);
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_LBA_HI, 0);
+
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_SECTOR_COUNT, (uint8_t)count);
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_LBA_LO, (uint8_t)lba);
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_LBA_MID, (uint8_t)(lba >> 8));
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_LBA_HI, (uint8_t)(lba >> 16));
+
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_COMMAND, command);
+}
+
+static void ata_init_multiple() {
+  uint8_t status;
+
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_DEVICE, ATA_DEVICE_MASTER_LBA);
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_SECTOR_COUNT,
+           ATA_MULTIPLE_BLOCK_SECTORS);
+  x86_outb(ATA_PRIMARY_IO_PORT + ATA_REG_COMMAND,
+           ATA_COMMAND_SET_MULTIPLE_MODE);
+
+  status = ata_wait_not_busy();
+  if (status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+    return;
+
+  ata_state.read_command = ATA_COMMAND_READ_MULTIPLE_EXT;
+  ata_state.block_sectors = ATA_MULTIPLE_BLOCK_SECTORS;
+}
+
+static void ide_dma_init() {
+  struct pci_location loc;
+  uint32_t class_revision, bar4, command;
+  uint8_t progif;
+
+  if (pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_STORAGE_IDE, &loc))
+    return;
+
+  /* The primary channel should be at the legacy ports to match PIO. */
+  class_revision = pci_config_read32(&loc, PCI_CONFIG_CLASS_REVISION);
+  progif = (uint8_t)(class_revision >> 8);
+  if (!(progif & IDE_PROGIF_BUS_MASTER) ||
+      (progif & IDE_PROGIF_PRIMARY_NATIVE))
+    return;
+
+  bar4 = pci_config_read32(&loc, PCI_CONFIG_BAR4);
+  if (!(bar4 & 0x1))
+    return;
+
+  command = pci_config_read32(&loc, PCI_CONFIG_COMMAND);
+  pci_config_write32(&loc, PCI_CONFIG_COMMAND,
+                     command | PCI_COMMAND_IO_SPACE | PCI_COMMAND_BUS_MASTER);
+
+  ata_state.bm_port = (uint16_t)(bar4 & 0xFFFC);
+}
+
+static int ata_pio_read_transfer(void *buffer, uint32_t lba,
+                                 uint32_t nsector) {
+  uint16_t *cur = (uint16_t *)buffer;
+
+  ata_send_lba48(lba, nsector, ata_state.read_command);
+
+  while (nsector > 0) {
+    uint8_t status = ata_wait_not_busy();
+    uint32_t count = ata_state.block_sectors;
+
+    if (status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+      return -1;
+    if (!(status & ATA_STATUS_DRQ))
+      continue;
+
+    /* Each DRQ block carries up to block_sectors sectors. */
+    if (count > nsector)
+      count = nsector;
+
+    x86_insw(ATA_PRIMARY_IO_PORT + ATA_REG_DATA, cur,
+             count * (ATA_SECTOR_SIZE / sizeof(*cur)));
+    cur += count * (ATA_SECTOR_SIZE / sizeof(*cur));
+    nsector -= count;
+  }
+
+  return 0;
+}
+
+static int ide_dma_read_transfer(void *buffer, uint32_t lba,
+                                 uint32_t nsector) {
+  const uint16_t bm_port = ata_state.bm_port;
+  uint32_t addr = (uint32_t)buffer;
+  uint32_t remaining = nsector * ATA_SECTOR_SIZE;
+  uint8_t bm_status, status;
+  int i;
+
+  for (i = 0; remaining > 0; ++i) {
+    uint32_t size = IDE_PRD_MAX_SIZE - (addr & (IDE_PRD_MAX_SIZE - 1));
+    if (size > remaining)
+      size = remaining;
+
+    /* Size of 0 stands for 64K. */
+    ide_prdt[i].addr = addr;
+    ide_prdt[i].size = (uint16_t)size;
+    ide_prdt[i].flags = 0;
+
+    addr += size;
+    remaining -= size;
+  }
+  ide_prdt[i - 1].flags = IDE_PRD_END_OF_TABLE;
+
+  x86_outb(bm_port + IDE_BM_REG_COMMAND, 0);
+  /* Error and interrupt bits are cleared by writing 1. */
+  x86_outb(bm_port + IDE_BM_REG_STATUS,
+           x86_inb(bm_port + IDE_BM_REG_STATUS) | IDE_BM_STATUS_ERROR |
+               IDE_BM_STATUS_INTERRUPT);
+  x86_outl(bm_port + IDE_BM_REG_PRDT, (uint32_t)ide_prdt);
+  x86_outb(bm_port + IDE_BM_REG_COMMAND, IDE_BM_COMMAND_READ);
+
+  ata_send_lba48(lba, nsector, ATA_COMMAND_READ_DMA_EXT);
+
+  x86_outb(bm_port + IDE_BM_REG_COMMAND,
+           IDE_BM_COMMAND_READ | IDE_BM_COMMAND_START);
+
+  /* Interrupt is disabled on the drive, so poll until the engine stops. */
+  do {
+    bm_status = x86_inb(bm_port + IDE_BM_REG_STATUS);
+  } while ((bm_status & IDE_BM_STATUS_ACTIVE) &&
+           !(bm_status & IDE_BM_STATUS_ERROR));
+
+  x86_outb(bm_port + IDE_BM_REG_COMMAND, 0);
+
+  status = ata_wait_not_busy();
+  if ((bm_status & IDE_BM_STATUS_ERROR) ||
+      (status & (ATA_STATUS_ERR | ATA_STATUS_DF)))
+    return -1;
+
+  return 0;
+}
+
+void ata_init() {
+  x86_outb(ATA_PRIMARY_CONTROL_PORT, ATA_CONTROL_NIEN);
+
+  ata_init_multiple();
+  ide_dma_init();
+}
+
+int ata_read(void *buffer, uint32_t lba, uint32_t nsector) {
+  char *cur = (char *)buffer;
+
+  while (nsector > 0) {
+    uint32_t count = 0;
+    int ret = -1;
+
+    if (ata_state.bm_port != 0) {
+      count = nsector < IDE_DMA_MAX_SECTORS ? nsector : IDE_DMA_MAX_SECTORS;
+      ret = ide_dma_read_transfer(cur, lba, count);
+
+      /* Do not retry DMA once the drive or the controller rejects it. */
+      if (ret)
+        ata_state.bm_port = 0;
+    }
+
+    if (ret) {
+      count =
+          nsector < ATA_LBA48_MAX_SECTORS ? nsector : ATA_LBA48_MAX_SECTORS;
+      ret = ata_pio_read_transfer(cur, lba, count);
+      if (ret)
+        return ret;
+    }
+
+    cur += count * ATA_SECTOR_SIZE;
+    lba += count;
+    nsector -= count;
+  }
+
+  return 0;
+}
@@ -1,7 +1,12 @@
 ; Origin is set to 0x7c00 by the linker script.
 BITS 16
 
-EXTERN kernel_start
+EXTERN stage2_start
+EXTERN STAGE2_RUNTIME_ADDR
+EXTERN STAGE2_LOAD_ADDR_SECTOR
+EXTERN STAGE2_SECTION_SIZE_SECTOR
+
+GLOBAL boot_sector_tsc
 
 SECTION .boot progbits alloc exec nowrite align=16
 
@@ -44,7 +49,16 @@ times 2 + 0x3C - ($ - $$) db 0
   mov sp, 0x7c00
   sti
 .finish_context_setup:
-  jmp protected_mode_bootstrap
+
+  ; Record the first checkpoint of the boot timeline for stage 2.
+  ; DL should be preserved, since it is used to read stage 2.
+  mov bl, dl
+  rdtsc
+  mov [boot_sector_tsc], eax
+  mov [boot_sector_tsc + 4], edx
+  mov dl, bl
+
+  jmp load_stage2
 
 printstr:
   mov bx, 0
@@ -63,159 +77,38 @@ printchar:
   int 0x10
   ret
 
-; Note that even though you should use 16 bit instructions in real mode, you can override to use 32 bit instructions for a single instruction.
-; See also: https://stackoverflow.com/questions/6917503/is-it-possible-to-use-32-bits-registers-instructions-in-real-mode
-protected_mode_bootstrap:
-  cli
-  lgdt[gdt_descriptor]
-  mov eax, cr0
-  or eax, 0x1
-  mov cr0, eax
-  ; sti ; TODO: Why do you need to disable interrupt here?
-
-%define CODE_SEG gdt_table_entry_code - gdt_table_start
-%define DATA_SEG gdt_table_entry_data - gdt_table_start
-
-  ; Jump is required to start protected mode functionality
-  jmp CODE_SEG:protected_mode_start
+; Stage 2 is read with the BIOS extended read, since DL still holds the boot drive.
+; Loading the kernel is left to stage 2 which has room for faster disk access.
+; See also: Ralf Brown's interrupt list, INT 13 - IBM/MS INT 13 Extensions - EXTENDED READ
+load_stage2:
+  mov si, stage2_disk_address_packet
+  mov ah, 0x42
+  int 0x13
+  jc .load_stage2_error
 
-BITS 32
+  jmp 0x0000:stage2_start
 
-protected_mode_start:
-
-.setup_data_segment_selector:
-  ; Setup data segment selectors here
-  mov ax, DATA_SEG
-  mov ds, ax
-  mov es, ax
-  mov fs, ax
-  mov gs, ax
-  mov ss, ax
-
-EXTERN TEXT_RUNTIME_ADDR
-EXTERN TEXT_LOAD_ADDR_SECTOR
-EXTERN TEXT_SECTION_SIZE_SECTOR
-
-EXTERN RODATA_RUNTIME_ADDR
-EXTERN RODATA_LOAD_ADDR_SECTOR
-EXTERN RODATA_SECTION_SIZE_SECTOR
-
-EXTERN DATA_RUNTIME_ADDR
-EXTERN DATA_LOAD_ADDR_SECTOR
-EXTERN DATA_SECTION_SIZE_SECTOR
-
-EXTERN BSS_RUNTIME_ADDR
-EXTERN BSS_SECTION_SIZE
-
-.load_kernel:
-  mov edi, TEXT_RUNTIME_ADDR
-  mov esi, TEXT_LOAD_ADDR_SECTOR
-  mov ecx, TEXT_SECTION_SIZE_SECTOR
-  call ata_lba_read_simple
-
-  mov edi, RODATA_RUNTIME_ADDR
-  mov esi, RODATA_LOAD_ADDR_SECTOR
-  mov ecx, RODATA_SECTION_SIZE_SECTOR
-  call ata_lba_read_simple
-
-  mov edi, DATA_RUNTIME_ADDR
-  mov esi, DATA_LOAD_ADDR_SECTOR
-  mov ecx, DATA_SECTION_SIZE_SECTOR
-  call ata_lba_read_simple
-
-  mov edi, BSS_RUNTIME_ADDR
-  mov ecx, BSS_SECTION_SIZE
-  shr ecx, 2
-  mov eax, 0
-  rep stosd
-
-.kernel_trampoline:
-  jmp kernel_start
-
-; void ata_lba_read_simple([edi] void *buffer, [esi] unsigned long diskaddr, [ecx] uint8_t nsector)
-ata_lba_read_simple:
-  test ecx, ecx
-  jne .proceed_read
-  ret
-
-.proceed_read:
-  ; Send lba[24:32]
-  mov edx, 0x01f6
-  mov eax, esi
-  shr eax, 24
-  or al, 0xe0
-  out dx, al
-
-  ; Send number of sectors to read
-  mov edx, 0x01f2
-  mov eax, ecx
-  out dx, al
-
-  ; Send lba[0:8]
-  mov edx, 0x1f3
-  mov eax, esi
-  out dx, al
-
-  ; Send lba[8:16]
-  mov edx, 0x1f4
-  mov eax, esi
-  shr eax, 8
-  out dx, al
-
-  ; Send lba[16:24]
-  mov edx, 0x1f5
-  mov eax, esi
-  shr eax, 16
-  out dx, al
-
-  mov esi, ecx
-.read_sector:
-  ; Initiate read operation
-  mov edx, 0x1f7
-  mov al, 0x20
-  out dx, al
-
-.wait_ready:
-  in al, dx
-  test al, 0x08
-  jz .wait_ready
-
-  mov edx, 0x1f0
-  mov ecx, 0x100 ; Read in word graularity, so repeat 256 times
-  rep insw
-
-  dec esi
-  jne .read_sector
-
-  ret
-
-BITS 16
-
-str_disk_success:
-  db "DISK READ SUCCESS", 0
-str_disk_error:
-  db "DISK READ ERROR", 0
-
-; GDT Descriptor
-times 480-($-$$) db 0
-
-gdt_table_start:
-gdt_table_entry_null:
-  dd 0x00000000
+.load_stage2_error:
+  mov si, str_stage2_error
+  call printstr
+  cli
+  hlt
+  jmp $
+
+stage2_disk_address_packet:
+  db 0x10 ; Size of packet
+  db 0x00
+  dw STAGE2_SECTION_SIZE_SECTOR
+  dw STAGE2_RUNTIME_ADDR ; Offset of buffer
+  dw 0x0000 ; Segment of buffer
+  dd STAGE2_LOAD_ADDR_SECTOR
   dd 0x00000000
 
-gdt_table_entry_code:
-  dw 0xffff, 0x0000
-  db 0x00, 0x9b, 0xcf, 0x00
-
-gdt_table_entry_data:
-  dw 0xffff, 0x0000
-  db 0x00, 0x93, 0xcf, 0x00
-gdt_table_end:
+boot_sector_tsc:
+  dq 0
 
-gdt_descriptor:
-  dw gdt_table_end - gdt_table_start - 1 ; Subtracted by 1 due to architecture design
-  dd gdt_table_start
+str_stage2_error:
+  db "STAGE2 LOAD ERROR", 0
 
 ; Boot signature
 times 510-($-$$) db 0
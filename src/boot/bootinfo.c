@@ -0,0 +1,196 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boot/bootinfo.h>
+#include <boot/e820.h>
+#include <boot/multiboot.h>
+#include <memory/memory.h>
+
+/**
+ * Kernel copy of the boot information, so that nothing handed over
+ * by the loader needs to be kept in place after boot_info_init.
+ */
+static struct boot_info kernel_boot_info_data;
+
+/* Multiboot memory map is converted here before it is sanitized. */
+static struct e820_entry multiboot_e820_map[E820_ENTRY_MAX];
+
+static void boot_info_copy_string(char *dst, const char *src) {
+  size_t i;
+
+  for (i = 0; i + 1 < BOOT_INFO_CMDLINE_MAX && src[i]; ++i)
+    dst[i] = src[i];
+  dst[i] = 0;
+}
+
+static void boot_info_add_module(uint32_t start, uint32_t end,
+                                 const char *cmdline) {
+  struct boot_info *info = &kernel_boot_info_data;
+
+  if (info->module_count == BOOT_INFO_MODULE_MAX)
+    return;
+
+  info->modules[info->module_count].start = start;
+  info->modules[info->module_count].end = end;
+  if (cmdline != NULL)
+    boot_info_copy_string(info->modules[info->module_count].cmdline, cmdline);
+
+  info->module_count++;
+}
+
+static void boot_info_set_e820(uint32_t count) {
+  struct boot_info *info = &kernel_boot_info_data;
+
+  info->e820_count =
+      e820_sanitize(multiboot_e820_map, count, info->e820, E820_ENTRY_MAX);
+  info->flags |= BOOT_INFO_FLAG_E820;
+}
+
+static void boot_info_from_multiboot(const struct multiboot_info *mbi) {
+  struct boot_info *info = &kernel_boot_info_data;
+
+  if (mbi->flags & MULTIBOOT_INFO_CMDLINE)
+    boot_info_copy_string(info->cmdline, (const char *)(uintptr_t)mbi->cmdline);
+
+  if (mbi->flags & MULTIBOOT_INFO_MODS) {
+    const struct multiboot_module *modules =
+        (const struct multiboot_module *)(uintptr_t)mbi->mods_addr;
+
+    for (uint32_t i = 0; i < mbi->mods_count; ++i)
+      boot_info_add_module(modules[i].mod_start, modules[i].mod_end,
+                           (const char *)(uintptr_t)modules[i].cmdline);
+  }
+
+  if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+    uintptr_t cur = mbi->mmap_addr;
+    uint32_t count = 0;
+
+    while (cur < mbi->mmap_addr + mbi->mmap_length &&
+           count < E820_ENTRY_MAX) {
+      const struct multiboot_mmap_entry *entry =
+          (const struct multiboot_mmap_entry *)cur;
+
+      multiboot_e820_map[count].base = entry->addr;
+      multiboot_e820_map[count].length = entry->len;
+      multiboot_e820_map[count].type = entry->type;
+      multiboot_e820_map[count].attr = E820_ATTR_ENABLED;
+      count++;
+
+      cur += entry->size + sizeof(entry->size);
+    }
+
+    boot_info_set_e820(count);
+  }
+
+  if (mbi->flags & MULTIBOOT_INFO_FRAMEBUFFER) {
+    info->framebuffer.addr = mbi->framebuffer_addr;
+    info->framebuffer.pitch = mbi->framebuffer_pitch;
+    info->framebuffer.width = mbi->framebuffer_width;
+    info->framebuffer.height = mbi->framebuffer_height;
+    info->framebuffer.bpp = mbi->framebuffer_bpp;
+    info->framebuffer.type = mbi->framebuffer_type;
+    info->flags |= BOOT_INFO_FLAG_FRAMEBUFFER;
+  }
+}
+
+static void boot_info_from_multiboot2(const struct multiboot2_info *mbi) {
+  struct boot_info *info = &kernel_boot_info_data;
+  uintptr_t cur = (uintptr_t)mbi + sizeof(*mbi);
+  const uintptr_t end = (uintptr_t)mbi + mbi->total_size;
+
+  while (cur + sizeof(struct multiboot2_tag) <= end) {
+    const struct multiboot2_tag *tag = (const struct multiboot2_tag *)cur;
+
+    if (tag->type == MULTIBOOT2_TAG_TYPE_END)
+      break;
+
+    switch (tag->type) {
+    case MULTIBOOT2_TAG_TYPE_CMDLINE: {
+      const struct multiboot2_tag_string *cmdline =
+          (const struct multiboot2_tag_string *)tag;
+
+      boot_info_copy_string(info->cmdline, cmdline->string);
+      break;
+    }
+    case MULTIBOOT2_TAG_TYPE_MODULE: {
+      const struct multiboot2_tag_module *module =
+          (const struct multiboot2_tag_module *)tag;
+
+      boot_info_add_module(module->mod_start, module->mod_end,
+                           module->cmdline);
+      break;
+    }
+    case MULTIBOOT2_TAG_TYPE_MMAP: {
+      const struct multiboot2_tag_mmap *mmap =
+          (const struct multiboot2_tag_mmap *)tag;
+      uintptr_t entry = cur + sizeof(*mmap);
+      uint32_t count = 0;
+
+      if (mmap->entry_size < sizeof(struct e820_entry))
+        break;
+
+      while (entry + mmap->entry_size <= cur + tag->size &&
+             count < E820_ENTRY_MAX) {
+        kmemcpy(&multiboot_e820_map[count], (const void *)entry,
+                sizeof(struct e820_entry));
+        multiboot_e820_map[count].attr = E820_ATTR_ENABLED;
+        count++;
+
+        entry += mmap->entry_size;
+      }
+
+      boot_info_set_e820(count);
+      break;
+    }
+    case MULTIBOOT2_TAG_TYPE_FRAMEBUFFER: {
+      const struct multiboot2_tag_framebuffer *fb =
+          (const struct multiboot2_tag_framebuffer *)tag;
+
+      info->framebuffer.addr = fb->framebuffer_addr;
+      info->framebuffer.pitch = fb->framebuffer_pitch;
+      info->framebuffer.width = fb->framebuffer_width;
+      info->framebuffer.height = fb->framebuffer_height;
+      info->framebuffer.bpp = fb->framebuffer_bpp;
+      info->framebuffer.type = fb->framebuffer_type;
+      info->flags |= BOOT_INFO_FLAG_FRAMEBUFFER;
+      break;
+    }
+    default:
+      break;
+    }
+
+    /* Tags are padded to 8 bytes. */
+    cur += (tag->size + MULTIBOOT2_TAG_ALIGN - 1) & ~(MULTIBOOT2_TAG_ALIGN - 1);
+  }
+}
+
+void boot_info_init(uint32_t magic, uint32_t addr) {
+  struct boot_info *info = &kernel_boot_info_data;
+
+  switch (magic) {
+  case BOOT_INFO_MAGIC:
+    kmemcpy(info, (const void *)(uintptr_t)addr, sizeof(*info));
+    if (!boot_info_valid(info))
+      kmemset(info, 0, sizeof(*info));
+    break;
+
+  case MULTIBOOT_BOOTLOADER_MAGIC:
+    info->magic = BOOT_INFO_MAGIC;
+    info->flags = BOOT_INFO_FLAG_MULTIBOOT;
+    boot_info_from_multiboot((const struct multiboot_info *)(uintptr_t)addr);
+    break;
+
+  case MULTIBOOT2_BOOTLOADER_MAGIC:
+    info->magic = BOOT_INFO_MAGIC;
+    info->flags = BOOT_INFO_FLAG_MULTIBOOT;
+    boot_info_from_multiboot2(
+        (const struct multiboot2_info *)(uintptr_t)addr);
+    break;
+
+  default:
+    /* Nothing is known, which is left as invalid. */
+    break;
+  }
+}
+
+const struct boot_info *kernel_boot_info() { return &kernel_boot_info_data; }
@@ -0,0 +1,138 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <boot/e820.h>
+
+#define E820_PRECEDENCE_COUNT 6
+#define E820_PRECEDENCE_RESERVED 4
+
+/**
+ * Entry types indexed by precedence, where the higher one wins
+ * where entries overlap. Precedence of 0 stands for no entry.
+ */
+static const uint32_t e820_types[E820_PRECEDENCE_COUNT] = {
+    0,
+    E820_TYPE_USABLE,
+    E820_TYPE_ACPI_RECLAIMABLE,
+    E820_TYPE_ACPI_NVS,
+    E820_TYPE_RESERVED,
+    E820_TYPE_BAD,
+};
+
+struct e820_boundary {
+  uint64_t addr;
+  unsigned int precedence;
+  bool start;
+};
+
+static struct e820_boundary e820_boundaries[2 * E820_ENTRY_MAX];
+
+/* Unknown types are treated as reserved. */
+static unsigned int e820_precedence(uint32_t type) {
+  for (unsigned int precedence = 1; precedence < E820_PRECEDENCE_COUNT;
+       ++precedence) {
+    if (e820_types[precedence] == type)
+      return precedence;
+  }
+
+  return E820_PRECEDENCE_RESERVED;
+}
+
+static uint32_t e820_append(struct e820_entry *dst, uint32_t count,
+                            uint32_t max, uint64_t base, uint64_t end,
+                            uint32_t type) {
+  if (count > 0) {
+    struct e820_entry *last = &dst[count - 1];
+
+    if (last->type == type && last->base + last->length == base) {
+      last->length = end - last->base;
+      return count;
+    }
+  }
+
+  if (count == max)
+    return count;
+
+  dst[count].base = base;
+  dst[count].length = end - base;
+  dst[count].type = type;
+  dst[count].attr = E820_ATTR_ENABLED;
+
+  return count + 1;
+}
+
+uint32_t e820_sanitize(const struct e820_entry *src, uint32_t count,
+                       struct e820_entry *dst, uint32_t max) {
+  uint32_t active[E820_PRECEDENCE_COUNT] = {0};
+  uint32_t nboundary = 0, ndst = 0;
+  unsigned int cur_precedence = 0;
+  uint64_t cur_base = 0;
+
+  if (count > E820_ENTRY_MAX)
+    count = E820_ENTRY_MAX;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const unsigned int precedence = e820_precedence(src[i].type);
+    uint64_t end = src[i].base + src[i].length;
+
+    if (src[i].length == 0 || !(src[i].attr & E820_ATTR_ENABLED))
+      continue;
+    if (end < src[i].base)
+      end = UINT64_MAX;
+
+    e820_boundaries[nboundary++] = (struct e820_boundary){
+        .addr = src[i].base,
+        .precedence = precedence,
+        .start = true,
+    };
+    e820_boundaries[nboundary++] = (struct e820_boundary){
+        .addr = end,
+        .precedence = precedence,
+        .start = false,
+    };
+  }
+
+  /* Insertion sort, since there are only a few entries. */
+  for (uint32_t i = 1; i < nboundary; ++i) {
+    struct e820_boundary boundary = e820_boundaries[i];
+    uint32_t pos;
+
+    for (pos = i; pos > 0; --pos) {
+      if (e820_boundaries[pos - 1].addr <= boundary.addr)
+        break;
+      e820_boundaries[pos] = e820_boundaries[pos - 1];
+    }
+    e820_boundaries[pos] = boundary;
+  }
+
+  for (uint32_t i = 0; i < nboundary; ++i) {
+    const struct e820_boundary *boundary = &e820_boundaries[i];
+    unsigned int precedence;
+
+    if (boundary->start)
+      active[boundary->precedence]++;
+    else
+      active[boundary->precedence]--;
+
+    /* Settle all boundaries at the same address before deciding the type. */
+    if (i + 1 < nboundary && e820_boundaries[i + 1].addr == boundary->addr)
+      continue;
+
+    for (precedence = E820_PRECEDENCE_COUNT - 1; precedence > 0; --precedence) {
+      if (active[precedence] != 0)
+        break;
+    }
+
+    if (precedence == cur_precedence)
+      continue;
+
+    if (cur_precedence != 0)
+      ndst = e820_append(dst, ndst, max, cur_base, boundary->addr,
+                         e820_types[cur_precedence]);
+
+    cur_precedence = precedence;
+    cur_base = boundary->addr;
+  }
+
+  return ndst;
+}
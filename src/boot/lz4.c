@@ -0,0 +1,103 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boot/lz4.h>
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LENGTH_MASK 0x0F
+#define LZ4_LENGTH_EXTEND 0xFF
+
+typedef uint32_t __attribute__((may_alias, aligned(1))) lz4_word_t;
+
+/**
+ * @brief Copy forward a word at a time, and the remainder a byte at a time.
+ *
+ * Regions may overlap only if dst is at least a word ahead of src,
+ * in which case every word read has already been written.
+ */
+static inline void lz4_copy(uint8_t *dst, const uint8_t *src, uint32_t size) {
+  while (size >= sizeof(lz4_word_t)) {
+    *(lz4_word_t *)dst = *(const lz4_word_t *)src;
+    dst += sizeof(lz4_word_t);
+    src += sizeof(lz4_word_t);
+    size -= sizeof(lz4_word_t);
+  }
+
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+static inline int lz4_read_length(const uint8_t **ip, const uint8_t *iend,
+                                  uint32_t *length) {
+  uint8_t c;
+
+  do {
+    if (*ip >= iend)
+      return -1;
+    c = *(*ip)++;
+    *length += c;
+  } while (c == LZ4_LENGTH_EXTEND);
+
+  return 0;
+}
+
+int lz4_decompress(const void *src, uint32_t src_size, void *dst,
+                   uint32_t dst_size) {
+  const uint8_t *ip = (const uint8_t *)src;
+  const uint8_t *const iend = ip + src_size;
+  uint8_t *op = (uint8_t *)dst;
+  uint8_t *const ostart = op;
+  uint8_t *const oend = op + dst_size;
+
+  while (ip < iend) {
+    const uint8_t token = *ip++;
+    uint32_t literal_length = token >> 4;
+    uint32_t match_length = token & LZ4_LENGTH_MASK;
+    uint32_t offset;
+    const uint8_t *match;
+
+    if (literal_length == LZ4_LENGTH_MASK &&
+        lz4_read_length(&ip, iend, &literal_length))
+      return -1;
+
+    if (literal_length > (uint32_t)(iend - ip) ||
+        literal_length > (uint32_t)(oend - op))
+      return -1;
+
+    lz4_copy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+
+    /* Last sequence has literals only. */
+    if (ip == iend)
+      break;
+
+    if (iend - ip < 2)
+      return -1;
+    offset = (uint32_t)ip[0] | ((uint32_t)ip[1] << 8);
+    ip += 2;
+
+    if (offset == 0 || offset > (uint32_t)(op - ostart))
+      return -1;
+    match = op - offset;
+
+    if (match_length == LZ4_LENGTH_MASK &&
+        lz4_read_length(&ip, iend, &match_length))
+      return -1;
+    match_length += LZ4_MIN_MATCH;
+
+    if (match_length > (uint32_t)(oend - op))
+      return -1;
+
+    if (offset >= sizeof(lz4_word_t)) {
+      lz4_copy(op, match, match_length);
+      op += match_length;
+    } else {
+      /* Short offsets repeat a pattern shorter than a word. */
+      for (uint32_t i = 0; i < match_length; ++i)
+        *op++ = *match++;
+    }
+  }
+
+  return (int)(op - ostart);
+}
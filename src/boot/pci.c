@@ -0,0 +1,62 @@
+#include <stdint.h>
+
+#include <boot/pci.h>
+#include <io/io.h>
+
+#define PCI_CONFIG_ADDRESS_PORT 0xCF8
+#define PCI_CONFIG_DATA_PORT 0xCFC
+
+#define PCI_CONFIG_ADDRESS_ENABLE 0x80000000UL
+
+#define PCI_MAX_DEVICE 32
+#define PCI_MAX_FUNCTION 8
+
+#define PCI_HEADER_TYPE_MULTIFUNCTION 0x80
+
+static inline uint32_t pci_config_address(const struct pci_location *loc,
+                                          uint8_t offset) {
+  return PCI_CONFIG_ADDRESS_ENABLE | ((uint32_t)loc->bus << 16) |
+         ((uint32_t)loc->device << 11) | ((uint32_t)loc->function << 8) |
+         (offset & 0xFC);
+}
+
+uint32_t pci_config_read32(const struct pci_location *loc, uint8_t offset) {
+  x86_outl(PCI_CONFIG_ADDRESS_PORT, pci_config_address(loc, offset));
+  return x86_inl(PCI_CONFIG_DATA_PORT);
+}
+
+void pci_config_write32(const struct pci_location *loc, uint8_t offset,
+                        uint32_t value) {
+  x86_outl(PCI_CONFIG_ADDRESS_PORT, pci_config_address(loc, offset));
+  x86_outl(PCI_CONFIG_DATA_PORT, value);
+}
+
+int pci_find_class(uint8_t class_code, uint8_t subclass,
+                   struct pci_location *loc) {
+  struct pci_location cur = {.bus = 0};
+
+  for (cur.device = 0; cur.device < PCI_MAX_DEVICE; ++cur.device) {
+    uint8_t nfunction = 1;
+
+    for (cur.function = 0; cur.function < nfunction; ++cur.function) {
+      uint32_t id = pci_config_read32(&cur, PCI_CONFIG_VENDOR_ID);
+      if ((id & 0xFFFF) == 0xFFFF)
+        continue;
+
+      if (cur.function == 0 &&
+          (pci_config_read32(&cur, PCI_CONFIG_HEADER_TYPE) >> 16) &
+              PCI_HEADER_TYPE_MULTIFUNCTION)
+        nfunction = PCI_MAX_FUNCTION;
+
+      uint32_t class_revision =
+          pci_config_read32(&cur, PCI_CONFIG_CLASS_REVISION);
+      if ((class_revision >> 24) == class_code &&
+          ((class_revision >> 16) & 0xFF) == subclass) {
+        *loc = cur;
+        return 0;
+      }
+    }
+  }
+
+  return -1;
+}
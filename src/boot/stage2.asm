@@ -0,0 +1,133 @@
+; Stage 2 is loaded right after the boot sector by <src/boot/boot.asm>,
+; and is entered in real mode at stage2_start.
+BITS 16
+
+EXTERN stage2_main
+EXTERN STAGE2_BSS_RUNTIME_ADDR
+EXTERN STAGE2_BSS_SECTION_SIZE
+
+GLOBAL stage2_start
+GLOBAL stage2_e820_map
+GLOBAL stage2_e820_count
+
+; This should match <include/boot/e820.h>.
+%define E820_ENTRY_SIZE 24
+%define E820_ENTRY_MAX 32
+%define E820_SIGNATURE 0x534D4150 ; "SMAP"
+
+SECTION .stage2 progbits alloc exec nowrite align=16
+
+stage2_start:
+
+.enable_a20_line:
+  ; Enable the A20 line before anything is loaded above 1M
+  in al, 0x92
+  or al, 0x02
+  out 0x92, al
+
+.clear_bss:
+  ; Stage 2 is below 64K, so bss can be cleared in real mode.
+  ; This should be done before anything is collected into bss.
+  ; C code assumes the direction flag to be cleared
+  cld
+  mov di, STAGE2_BSS_RUNTIME_ADDR
+  mov cx, STAGE2_BSS_SECTION_SIZE
+  mov al, 0
+  rep stosb
+
+; The memory map is only available through the BIOS, so collect it before leaving real mode.
+; Sorting and merging the entries is left to stage2_main.
+; See also: Ralf Brown's interrupt list, INT 15 - newer BIOSes - GET SYSTEM MEMORY MAP
+.collect_memory_map:
+  mov ebx, 0
+  mov di, stage2_e820_map
+.collect_memory_map_entry:
+  ; Entry is enabled if the BIOS does not return the extended attributes.
+  mov dword [di + 20], 1
+  mov eax, 0xE820
+  mov ecx, E820_ENTRY_SIZE
+  mov edx, E820_SIGNATURE
+  int 0x15
+  ; Carry is set either when not supported, or past the last entry.
+  jc .finish_memory_map
+  cmp eax, E820_SIGNATURE
+  jne .finish_memory_map
+
+  add di, E820_ENTRY_SIZE
+  inc dword [stage2_e820_count]
+  cmp dword [stage2_e820_count], E820_ENTRY_MAX
+  jae .finish_memory_map
+
+  ; Continuation value of 0 means this was the last entry.
+  cmp ebx, 0
+  jne .collect_memory_map_entry
+.finish_memory_map:
+
+; Note that even though you should use 16 bit instructions in real mode, you can override to use 32 bit instructions for a single instruction.
+; See also: https://stackoverflow.com/questions/6917503/is-it-possible-to-use-32-bits-registers-instructions-in-real-mode
+protected_mode_bootstrap:
+  cli
+  lgdt[gdt_descriptor]
+  mov eax, cr0
+  or eax, 0x1
+  mov cr0, eax
+  ; sti ; TODO: Why do you need to disable interrupt here?
+
+%define CODE_SEG gdt_table_entry_code - gdt_table_start
+%define DATA_SEG gdt_table_entry_data - gdt_table_start
+
+  ; Jump is required to start protected mode functionality
+  jmp CODE_SEG:protected_mode_start
+
+BITS 32
+
+protected_mode_start:
+
+.setup_data_segment_selector:
+  ; Setup data segment selectors here
+  mov ax, DATA_SEG
+  mov ds, ax
+  mov es, ax
+  mov fs, ax
+  mov gs, ax
+  mov ss, ax
+
+%define STAGE2_STACK_ADDR 0x7c00
+
+.setup_stack:
+  ; Reuse the stack below the boot sector
+  mov ebp, STAGE2_STACK_ADDR
+  mov esp, ebp
+
+  call stage2_main
+
+  jmp $
+
+align 8
+
+gdt_table_start:
+gdt_table_entry_null:
+  dd 0x00000000
+  dd 0x00000000
+
+gdt_table_entry_code:
+  dw 0xffff, 0x0000
+  db 0x00, 0x9b, 0xcf, 0x00
+
+gdt_table_entry_data:
+  dw 0xffff, 0x0000
+  db 0x00, 0x93, 0xcf, 0x00
+gdt_table_end:
+
+gdt_descriptor:
+  dw gdt_table_end - gdt_table_start - 1 ; Subtracted by 1 due to architecture design
+  dd gdt_table_start
+
+SECTION .bss
+
+; Raw entries as returned by the BIOS, read by <src/boot/stage2.c>.
+align 8
+stage2_e820_map:
+  resb E820_ENTRY_SIZE * E820_ENTRY_MAX
+stage2_e820_count:
+  resd 1
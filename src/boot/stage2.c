@@ -0,0 +1,310 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boot/ata.h>
+#include <boot/bootinfo.h>
+#include <boot/e820.h>
+#include <boot/elf.h>
+#include <boot/lz4.h>
+#include <boot/stage2.h>
+#include <cpu/cpu.h>
+#include <memory/memory.h>
+
+/* This is a symbol in <src/boot/boot.ld>, where only the address matters. */
+extern char KERNEL_ELF_LOAD_ADDR_SECTOR[];
+
+/* This is stamped by <src/boot/boot.asm> on entry. */
+extern uint64_t boot_sector_tsc;
+
+/* These are collected by <src/boot/stage2.asm> in real mode. */
+extern struct e820_entry stage2_e820_map[E820_ENTRY_MAX];
+extern uint32_t stage2_e820_count;
+
+/* ELF header and program headers are expected to fit in the first page. */
+#define KERNEL_HEADER_SIZE 0x1000
+#define KERNEL_SEGMENT_MAX 16
+
+#define STAGE2_PAGE_SIZE 0x1000
+
+/**
+ * Segments are read together when the file gap between them matches
+ * the memory gap, so that the padding is read instead of issuing
+ * another command. Large gaps are not worth reading.
+ */
+#define KERNEL_EXTENT_GAP_MAX 0x10000
+
+struct kernel_segment {
+  uint32_t offset;
+  uint32_t paddr;
+  uint32_t filesz;
+  uint32_t memsz;
+};
+
+static union {
+  struct elf32_ehdr ehdr;
+  struct lz4_kernel_header lz4;
+  char buf[KERNEL_HEADER_SIZE];
+} kernel_header;
+
+static char sector_buffer[ATA_SECTOR_SIZE];
+
+static struct kernel_segment kernel_segments[KERNEL_SEGMENT_MAX];
+static int kernel_nsegment;
+
+static inline void stage2_stamp(enum boot_phase phase) {
+  boot_info_get()->timeline[phase] = x86_rdtsc();
+}
+
+static void stage2_panic(const char *str) {
+  /* Terminal is not available yet, so write to video memory directly. */
+  volatile uint16_t *video_mem = (volatile uint16_t *)0xB8000;
+
+  while (*str)
+    *video_mem++ = 0x0400 | (uint8_t)*str++;
+
+  while (1) {
+  }
+}
+
+/**
+ * @brief Read a byte range of the kernel ELF file.
+ *
+ * Whole sectors are read into the destination directly,
+ * and partial sectors at either end go through a bounce buffer.
+ */
+static int stage2_read_kernel(void *dst, uint32_t offset, uint32_t size) {
+  const uint32_t kernel_lba = (uint32_t)KERNEL_ELF_LOAD_ADDR_SECTOR;
+  uint32_t lba = kernel_lba + offset / ATA_SECTOR_SIZE;
+  uint32_t head = offset % ATA_SECTOR_SIZE;
+  char *cur = (char *)dst;
+
+  if (head != 0 && size > 0) {
+    uint32_t count = ATA_SECTOR_SIZE - head;
+    if (count > size)
+      count = size;
+
+    if (ata_read(sector_buffer, lba, 1))
+      return -1;
+    kmemcpy(cur, sector_buffer + head, count);
+
+    cur += count;
+    size -= count;
+    lba++;
+  }
+
+  if (size >= ATA_SECTOR_SIZE) {
+    uint32_t nsector = size / ATA_SECTOR_SIZE;
+
+    if (ata_read(cur, lba, nsector))
+      return -1;
+
+    cur += nsector * ATA_SECTOR_SIZE;
+    size -= nsector * ATA_SECTOR_SIZE;
+    lba += nsector;
+  }
+
+  if (size > 0) {
+    if (ata_read(sector_buffer, lba, 1))
+      return -1;
+    kmemcpy(cur, sector_buffer, size);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Collect PT_LOAD segments sorted by file offset.
+ */
+static int stage2_plan_kernel(const struct elf32_ehdr *ehdr) {
+  if (kmemcmp(ehdr->ident, ELF_MAGIC, ELF_MAGIC_SIZE) ||
+      ehdr->ident[ELF_IDENT_CLASS] != ELF_CLASS_32 ||
+      ehdr->ident[ELF_IDENT_DATA] != ELF_DATA_LSB ||
+      ehdr->type != ELF_TYPE_EXEC || ehdr->machine != ELF_MACHINE_386)
+    return -1;
+
+  if (ehdr->phentsize < sizeof(struct elf32_phdr) ||
+      ehdr->phoff > KERNEL_HEADER_SIZE ||
+      (uint32_t)ehdr->phnum * ehdr->phentsize >
+          KERNEL_HEADER_SIZE - ehdr->phoff)
+    return -1;
+
+  kernel_nsegment = 0;
+  for (int i = 0; i < ehdr->phnum; ++i) {
+    const struct elf32_phdr *phdr =
+        (const struct elf32_phdr *)(kernel_header.buf + ehdr->phoff +
+                                    i * ehdr->phentsize);
+    int pos;
+
+    if (phdr->type != ELF_PT_LOAD || phdr->memsz == 0)
+      continue;
+    if (kernel_nsegment == KERNEL_SEGMENT_MAX || phdr->filesz > phdr->memsz)
+      return -1;
+
+    /* Insertion sort, since there are only a few segments. */
+    for (pos = kernel_nsegment; pos > 0; --pos) {
+      if (kernel_segments[pos - 1].offset <= phdr->offset)
+        break;
+      kernel_segments[pos] = kernel_segments[pos - 1];
+    }
+
+    kernel_segments[pos].offset = phdr->offset;
+    kernel_segments[pos].paddr = phdr->paddr;
+    kernel_segments[pos].filesz = phdr->filesz;
+    kernel_segments[pos].memsz = phdr->memsz;
+    kernel_nsegment++;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Load all planned segments with as few reads as possible.
+ */
+static int stage2_load_kernel() {
+  int i = 0;
+
+  while (i < kernel_nsegment) {
+    const struct kernel_segment *first = &kernel_segments[i];
+    int last = i;
+    uint32_t size;
+
+    while (last + 1 < kernel_nsegment) {
+      const struct kernel_segment *cur = &kernel_segments[last];
+      const struct kernel_segment *next = &kernel_segments[last + 1];
+      uint32_t gap;
+
+      /* Zero filled tail should not be overwritten by the next read. */
+      if (cur->filesz != cur->memsz ||
+          next->offset < cur->offset + cur->filesz)
+        break;
+
+      gap = next->offset - (cur->offset + cur->filesz);
+      if (gap > KERNEL_EXTENT_GAP_MAX ||
+          next->paddr != cur->paddr + cur->filesz + gap)
+        break;
+
+      last++;
+    }
+
+    size = kernel_segments[last].offset + kernel_segments[last].filesz -
+           first->offset;
+    if (size > 0 &&
+        stage2_read_kernel((void *)first->paddr, first->offset, size))
+      return -1;
+
+    i = last + 1;
+  }
+
+  stage2_stamp(BOOT_PHASE_KERNEL_READ);
+
+  for (i = 0; i < kernel_nsegment; ++i) {
+    const struct kernel_segment *segment = &kernel_segments[i];
+
+    kmemset((void *)(segment->paddr + segment->filesz), 0,
+            segment->memsz - segment->filesz);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Read the compressed kernel payload and decompress it in place.
+ *
+ * The payload is staged right after the memory used by the kernel,
+ * so that it does not overlap with the decompressed image.
+ */
+static int stage2_load_kernel_lz4(const struct lz4_kernel_header *header) {
+  struct boot_info *info = boot_info_get();
+  uint8_t *dst = (uint8_t *)header->load_addr;
+  uint8_t *staging =
+      (uint8_t *)((header->load_addr + header->mem_size + STAGE2_PAGE_SIZE -
+                   1) &
+                  ~(STAGE2_PAGE_SIZE - 1));
+  uint64_t decode_start;
+  int ret;
+
+  if (header->header_size < sizeof(*header) ||
+      header->image_size > header->mem_size)
+    return -1;
+
+  if (stage2_read_kernel(staging, 0,
+                         header->header_size + header->compressed_size))
+    return -1;
+
+  stage2_stamp(BOOT_PHASE_KERNEL_READ);
+
+  decode_start = x86_rdtsc();
+  ret = lz4_decompress(staging + header->header_size, header->compressed_size,
+                       dst, header->image_size);
+  info->kernel_lz4.decode_cycles = x86_rdtsc() - decode_start;
+
+  if (ret < 0 || (uint32_t)ret != header->image_size)
+    return -1;
+
+  kmemset(dst + header->image_size, 0,
+          header->mem_size - header->image_size);
+
+  info->kernel_lz4.compressed_size = header->compressed_size;
+  info->kernel_lz4.uncompressed_size = header->image_size;
+  info->flags |= BOOT_INFO_FLAG_KERNEL_LZ4;
+
+  return 0;
+}
+
+/**
+ * @brief Jump to the kernel with the boot information.
+ *
+ * Registers are set up the same way as Multiboot loaders do,
+ * so that the kernel can tell which one loaded it.
+ */
+static void stage2_enter_kernel(uint32_t entry) {
+  __asm__ volatile("jmp *%0"
+                   :
+                   : "c"(entry), "a"(BOOT_INFO_MAGIC), "b"(BOOT_INFO_ADDR)
+                   : "memory");
+
+  while (1) {
+  }
+}
+
+void stage2_main() {
+  struct boot_info *info = boot_info_get();
+
+  kmemset(info, 0, sizeof(*info));
+  info->magic = BOOT_INFO_MAGIC;
+  info->timeline[BOOT_PHASE_BOOT_SECTOR] = boot_sector_tsc;
+  stage2_stamp(BOOT_PHASE_STAGE2);
+
+  if (stage2_e820_count > 0) {
+    info->e820_count = e820_sanitize(stage2_e820_map, stage2_e820_count,
+                                     info->e820, E820_ENTRY_MAX);
+    info->flags |= BOOT_INFO_FLAG_E820;
+  }
+
+  ata_init();
+
+  /* Compressed payload may be smaller than the ELF header page. */
+  if (stage2_read_kernel(kernel_header.buf, 0, ATA_SECTOR_SIZE))
+    stage2_panic("Failed to read kernel header from disk.");
+
+  if (!kmemcmp(kernel_header.lz4.magic, LZ4_KERNEL_MAGIC,
+               LZ4_KERNEL_MAGIC_SIZE)) {
+    if (stage2_load_kernel_lz4(&kernel_header.lz4))
+      stage2_panic("Failed to load compressed kernel image.");
+
+    stage2_stamp(BOOT_PHASE_KERNEL_LOADED);
+    stage2_enter_kernel(kernel_header.lz4.entry);
+  }
+
+  if (stage2_read_kernel(kernel_header.buf, 0, sizeof(kernel_header.buf)))
+    stage2_panic("Failed to read kernel header from disk.");
+
+  if (stage2_plan_kernel(&kernel_header.ehdr))
+    stage2_panic("Kernel is not a loadable ELF image.");
+
+  if (stage2_load_kernel())
+    stage2_panic("Failed to read kernel image from disk.");
+
+  stage2_stamp(BOOT_PHASE_KERNEL_LOADED);
+  stage2_enter_kernel(kernel_header.ehdr.entry);
+}
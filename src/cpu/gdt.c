@@ -0,0 +1,101 @@
+#include <stdint.h>
+
+#include <config.h>
+#include <cpu/gdt.h>
+
+#define GDT_ACCESS_ACCESSED (1U << 0)
+#define GDT_ACCESS_READ_WRITE (1U << 1)
+#define GDT_ACCESS_EXECUTABLE (1U << 3)
+#define GDT_ACCESS_CODE_DATA (1U << 4)
+#define GDT_ACCESS_PRESENT (1U << 7)
+
+#define GDT_FLAG_LONG (1U << 1)
+#define GDT_FLAG_32BIT (1U << 2)
+#define GDT_FLAG_GRANULARITY_4K (1U << 3)
+
+/**
+ * Accessed bit is set in advance, so that the processor does not
+ * write to the table when a segment is loaded.
+ */
+#define GDT_ACCESS_KERNEL_CODE                                                 \
+  (GDT_ACCESS_PRESENT | GDT_ACCESS_CODE_DATA | GDT_ACCESS_EXECUTABLE |         \
+   GDT_ACCESS_READ_WRITE | GDT_ACCESS_ACCESSED)
+#define GDT_ACCESS_KERNEL_DATA                                                 \
+  (GDT_ACCESS_PRESENT | GDT_ACCESS_CODE_DATA | GDT_ACCESS_READ_WRITE |         \
+   GDT_ACCESS_ACCESSED)
+
+#ifdef CONFIG_X86_64
+#define GDT_FLAGS_KERNEL_CODE (GDT_FLAG_GRANULARITY_4K | GDT_FLAG_LONG)
+#else
+#define GDT_FLAGS_KERNEL_CODE (GDT_FLAG_GRANULARITY_4K | GDT_FLAG_32BIT)
+#endif /* CONFIG_X86_64 */
+#define GDT_FLAGS_KERNEL_DATA (GDT_FLAG_GRANULARITY_4K | GDT_FLAG_32BIT)
+
+/* Limit in 4K units, which covers the whole 4G. */
+#define GDT_LIMIT_MAX 0xFFFFFU
+
+struct __attribute__((packed)) gdt_entry {
+  uint16_t limit_lo;
+  uint16_t base_lo;
+  uint8_t base_mid;
+  uint8_t access;
+  uint8_t flags_limit_hi;
+  uint8_t base_hi;
+};
+
+struct __attribute__((packed)) gdt_descriptor {
+  uint16_t size;
+  uintptr_t table;
+};
+
+static struct gdt_entry gdt_table[GDT_ENTRY_COUNT]
+    __attribute__((aligned(sizeof(struct gdt_entry))));
+
+static void gdt_set(struct gdt_entry *entry, uint32_t base, uint32_t limit,
+                    uint8_t access, uint8_t flags) {
+  entry->limit_lo = (uint16_t)limit;
+  entry->base_lo = (uint16_t)base;
+  entry->base_mid = (uint8_t)(base >> 16);
+  entry->access = access;
+  entry->flags_limit_hi = (uint8_t)((flags << 4) | ((limit >> 16) & 0x0F));
+  entry->base_hi = (uint8_t)(base >> 24);
+}
+
+void gdt_init() {
+  gdt_set(&gdt_table[GDT_ENTRY_NULL], 0, 0, 0, 0);
+  gdt_set(&gdt_table[GDT_ENTRY_KERNEL_CODE], 0, GDT_LIMIT_MAX,
+          GDT_ACCESS_KERNEL_CODE, GDT_FLAGS_KERNEL_CODE);
+  gdt_set(&gdt_table[GDT_ENTRY_KERNEL_DATA], 0, GDT_LIMIT_MAX,
+          GDT_ACCESS_KERNEL_DATA, GDT_FLAGS_KERNEL_DATA);
+
+  for (unsigned int cpu = 0; cpu < CONFIG_MAX_CPUS; ++cpu)
+    gdt_set_percpu_base(cpu, 0);
+
+  gdt_load();
+}
+
+void gdt_load() {
+  struct gdt_descriptor descriptor = {
+      .size = (uint16_t)(sizeof(gdt_table) - 1),
+      .table = (uintptr_t)gdt_table,
+  };
+
+  /**
+   * Code segment is not reloaded, since its descriptor is the same
+   * as the one the processor already has. GS is left to the per-CPU setup.
+   */
+  __asm__ volatile("lgdt %[descriptor]\n\t"
+                   "mov %[data], %%ds\n\t"
+                   "mov %[data], %%es\n\t"
+                   "mov %[data], %%fs\n\t"
+                   "mov %[data], %%ss"
+                   :
+                   : [descriptor] "m"(descriptor),
+                     [data] "r"((uint16_t)KERNEL_DATA_SELECTOR)
+                   : "memory");
+}
+
+void gdt_set_percpu_base(unsigned int cpu, uintptr_t base) {
+  gdt_set(&gdt_table[GDT_ENTRY_PERCPU_BASE + cpu], (uint32_t)base,
+          GDT_LIMIT_MAX, GDT_ACCESS_KERNEL_DATA, GDT_FLAGS_KERNEL_DATA);
+}
@@ -0,0 +1,74 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <config.h>
+#include <cpu/cpu.h>
+#include <cpu/gdt.h>
+#include <cpu/percpu.h>
+#include <memory/memory.h>
+#include <memory/page_alloc.h>
+
+/* These are symbols in <src/script.ld>, where only the address matters. */
+extern char PER_CPU_START[];
+extern char PER_CPU_END[];
+
+uintptr_t percpu_offsets[CONFIG_MAX_CPUS];
+
+DEFINE_PER_CPU(unsigned int, percpu_cpu);
+DEFINE_PER_CPU(uintptr_t, percpu_offset);
+
+static inline size_t percpu_size() {
+  return (size_t)(PER_CPU_END - PER_CPU_START);
+}
+
+/**
+ * @brief Point GS of the calling processor to the per-CPU area.
+ *
+ * Segment bases wrap around at 4G in protected mode, so the offset works
+ * even if the copy is below the area of the bootstrap processor.
+ * In long mode, the base is taken from the MSR instead of the descriptor.
+ */
+static void percpu_load(unsigned int cpu) {
+  __asm__ volatile("mov %0, %%gs"
+                   :
+                   : "r"((uint16_t)GDT_PERCPU_SELECTOR(cpu))
+                   : "memory");
+#ifdef CONFIG_X86_64
+  x86_wrmsr(X86_MSR_GS_BASE, percpu_offsets[cpu]);
+#endif /* CONFIG_X86_64 */
+}
+
+void percpu_init() {
+  gdt_init();
+
+  /* Bootstrap processor uses the area in place, which is already zero. */
+  percpu_offsets[0] = 0;
+  percpu_load(0);
+}
+
+int percpu_alloc(unsigned int cpu) {
+  void *area = get_pages(percpu_size());
+
+  if (area == NULL)
+    return -1;
+
+  kmemset(area, 0, percpu_size());
+  percpu_offsets[cpu] = (uintptr_t)area - (uintptr_t)PER_CPU_START;
+  gdt_set_percpu_base(cpu, percpu_offsets[cpu]);
+
+  return 0;
+}
+
+void percpu_free(unsigned int cpu) {
+  return_pages((void *)((uintptr_t)PER_CPU_START + percpu_offsets[cpu]),
+               percpu_size());
+  percpu_offsets[cpu] = 0;
+}
+
+void percpu_init_ap(unsigned int cpu) {
+  gdt_load();
+  percpu_load(cpu);
+
+  this_cpu_write(percpu_cpu, cpu);
+  this_cpu_write(percpu_offset, percpu_offsets[cpu]);
+}
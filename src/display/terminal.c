@@ -4,6 +4,7 @@
 
 #include <display/display.h>
 #include <display/format.h>
+#include <sync/spinlock.h>
 
 typedef uint16_t video_mem_entry_t;
 static inline uint16_t terminal_make_char(char c, unsigned char color) {
@@ -33,6 +34,12 @@ static inline bool terminal_state_writable(const struct terminal_t *state) {
 
 static struct terminal_t terminal_state;
 
+/**
+ * Serializes whole messages from every processor and interrupt handler,
+ * so that lines are not interleaved with each other.
+ */
+static struct spinlock terminal_lock = SPINLOCK_INIT;
+
 void terminal_init() {
   for (unsigned int y = 0; y < VIDEO_HEIGHT; ++y) {
     for (unsigned int x = 0; x < VIDEO_WIDTH; ++x) {
@@ -118,8 +125,12 @@ terminal_print_color_cb(int (*putchar_color_cb)(char c, unsigned char color),
 }
 
 int terminal_print(const char *str) {
-  return terminal_print_color_cb(terminal_putchar_color, str,
-                                 TERMINAL_COLOR_DEFAULT);
+  unsigned long flags = spin_lock_irqsave(&terminal_lock);
+  int ret = terminal_print_color_cb(terminal_putchar_color, str,
+                                    TERMINAL_COLOR_DEFAULT);
+
+  spin_unlock_irqrestore(&terminal_lock, flags);
+  return ret;
 }
 
 static inline void terminal_putchar_default_color_cb(void *ctx, char c) {
@@ -136,11 +147,14 @@ static inline void terminal_putchar_default_color_cb(void *ctx, char c) {
 
 int terminal_printk(const char *fmt, ...) {
   int ret = 0, pret = 0;
+  unsigned long flags;
   va_list args;
 
   va_start(args, fmt);
 
+  flags = spin_lock_irqsave(&terminal_lock);
   ret = vcbprintf(terminal_putchar_default_color_cb, (void *)&pret, fmt, args);
+  spin_unlock_irqrestore(&terminal_lock, flags);
 
   va_end(args);
 
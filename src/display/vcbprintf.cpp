@@ -58,7 +58,7 @@ public:
 
   template <typename CharType> void PutStr(CharType *s) {
     while (true) {
-      CharType c = *s;
+      CharType c = *s++;
 
       if (c == 0)
         break;
@@ -161,7 +161,9 @@ protected:
         IntType cur = x;
         for (unsigned int k = 0; k < NWORD; ++k) {
           word[NWORD - 1 - k] = (cur & WORD_MASK);
-          cur >>= BITS_IN_WORD;
+          /* Shifting by the full width is undefined for a single word. */
+          if constexpr (NWORD > 1)
+            cur >>= BITS_IN_WORD;
         }
       }
 
@@ -0,0 +1,127 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <display/display.h>
+#include <idt/exception.h>
+#include <idt/irq.h>
+
+static const char *const exception_names[X86_EXCEPTION_COUNT] = {
+    [X86_EXCEPTION_DIVIDE_ERROR] = "Divide error",
+    [X86_EXCEPTION_DEBUG] = "Debug",
+    [X86_EXCEPTION_NMI] = "Non-maskable interrupt",
+    [X86_EXCEPTION_BREAKPOINT] = "Breakpoint",
+    [X86_EXCEPTION_OVERFLOW] = "Overflow",
+    [X86_EXCEPTION_BOUND_RANGE] = "Bound range exceeded",
+    [X86_EXCEPTION_INVALID_OPCODE] = "Invalid opcode",
+    [X86_EXCEPTION_DEVICE_NOT_AVAILABLE] = "Device not available",
+    [X86_EXCEPTION_DOUBLE_FAULT] = "Double fault",
+    [X86_EXCEPTION_INVALID_TSS] = "Invalid TSS",
+    [X86_EXCEPTION_SEGMENT_NOT_PRESENT] = "Segment not present",
+    [X86_EXCEPTION_STACK_FAULT] = "Stack fault",
+    [X86_EXCEPTION_GENERAL_PROTECTION] = "General protection fault",
+    [X86_EXCEPTION_PAGE_FAULT] = "Page fault",
+    [X86_EXCEPTION_X87_FLOATING_POINT] = "x87 floating point error",
+    [X86_EXCEPTION_ALIGNMENT_CHECK] = "Alignment check",
+    [X86_EXCEPTION_MACHINE_CHECK] = "Machine check",
+    [X86_EXCEPTION_SIMD_FLOATING_POINT] = "SIMD floating point error",
+    [X86_EXCEPTION_VIRTUALIZATION] = "Virtualization exception",
+    [X86_EXCEPTION_CONTROL_PROTECTION] = "Control protection exception",
+};
+
+static const char *exception_name(unsigned int vector) {
+  if (vector >= X86_EXCEPTION_COUNT || exception_names[vector] == NULL)
+    return "Reserved exception";
+  return exception_names[vector];
+}
+
+#ifdef CONFIG_X86_64
+#define EXCEPTION_REG "%016lx"
+
+static void exception_dump(const struct trap_frame *frame) {
+  terminal_printk("rax=" EXCEPTION_REG " rbx=" EXCEPTION_REG
+                  " rcx=" EXCEPTION_REG "\n",
+                  frame->rax, frame->rbx, frame->rcx);
+  terminal_printk("rdx=" EXCEPTION_REG " rsi=" EXCEPTION_REG
+                  " rdi=" EXCEPTION_REG "\n",
+                  frame->rdx, frame->rsi, frame->rdi);
+  terminal_printk("rbp=" EXCEPTION_REG " rsp=" EXCEPTION_REG
+                  " r8 =" EXCEPTION_REG "\n",
+                  frame->rbp, frame->rsp, frame->r8);
+  terminal_printk("r9 =" EXCEPTION_REG " r10=" EXCEPTION_REG
+                  " r11=" EXCEPTION_REG "\n",
+                  frame->r9, frame->r10, frame->r11);
+  terminal_printk("r12=" EXCEPTION_REG " r13=" EXCEPTION_REG
+                  " r14=" EXCEPTION_REG "\n",
+                  frame->r12, frame->r13, frame->r14);
+  terminal_printk("r15=" EXCEPTION_REG " rip=" EXCEPTION_REG
+                  " rfl=" EXCEPTION_REG "\n",
+                  frame->r15, frame->rip, frame->rflags);
+}
+
+static inline uintptr_t exception_ip(const struct trap_frame *frame) {
+  return frame->rip;
+}
+#else
+#define EXCEPTION_REG "%08lx"
+
+static void exception_dump(const struct trap_frame *frame) {
+  /* Stack pointer before the interrupt is right above the frame. */
+  const unsigned long esp = (unsigned long)(uintptr_t)(frame + 1);
+
+  terminal_printk("eax=" EXCEPTION_REG " ebx=" EXCEPTION_REG
+                  " ecx=" EXCEPTION_REG " edx=" EXCEPTION_REG "\n",
+                  (unsigned long)frame->eax, (unsigned long)frame->ebx,
+                  (unsigned long)frame->ecx, (unsigned long)frame->edx);
+  terminal_printk("esi=" EXCEPTION_REG " edi=" EXCEPTION_REG
+                  " ebp=" EXCEPTION_REG " esp=" EXCEPTION_REG "\n",
+                  (unsigned long)frame->esi, (unsigned long)frame->edi,
+                  (unsigned long)frame->ebp, esp);
+  terminal_printk("eip=" EXCEPTION_REG " efl=" EXCEPTION_REG "\n",
+                  (unsigned long)frame->eip, (unsigned long)frame->eflags);
+}
+
+static inline uintptr_t exception_ip(const struct trap_frame *frame) {
+  return frame->eip;
+}
+#endif /* CONFIG_X86_64 */
+
+/**
+ * @brief Default handler of faults, which cannot be resumed
+ * without fixing what caused them.
+ */
+static void exception_fatal(struct trap_frame *frame, void *ctx) {
+  terminal_printk("%s on CPU %u, error code " EXCEPTION_REG "\n",
+                  exception_name(frame->vector), smp_processor_id(),
+                  (unsigned long)frame->error_code);
+
+  if (frame->vector == X86_EXCEPTION_PAGE_FAULT)
+    terminal_printk("Faulting address " EXCEPTION_REG "\n",
+                    (unsigned long)x86_read_cr2());
+
+  exception_dump(frame);
+
+  /* Interrupts are disabled by the interrupt gate. */
+  while (1) {
+    x86_halt();
+  }
+}
+
+/**
+ * @brief Default handler of traps, which resume after the instruction.
+ */
+static void exception_report(struct trap_frame *frame, void *ctx) {
+  terminal_printk("%s at " EXCEPTION_REG "\n", exception_name(frame->vector),
+                  (unsigned long)exception_ip(frame));
+}
+
+void exception_init() {
+  for (unsigned int vector = 0; vector < X86_EXCEPTION_COUNT; ++vector)
+    irq_register(vector, exception_fatal, NULL);
+
+  irq_register(X86_EXCEPTION_DEBUG, exception_report, NULL);
+  irq_register(X86_EXCEPTION_NMI, exception_report, NULL);
+  irq_register(X86_EXCEPTION_BREAKPOINT, exception_report, NULL);
+  irq_register(X86_EXCEPTION_OVERFLOW, exception_report, NULL);
+}
@@ -1,18 +1,115 @@
+EXTERN irq_dispatch
 
-%macro define_interrupt_entrypoint 2
-GLOBAL %1
-EXTERN %2
+GLOBAL idt_stub_table
 
-%1:
-  cli
+; This should match <include/config.h>.
+%define CONFIG_NUM_INTERRUPTS 0x100
+
+; Exceptions for which the processor pushes an error code.
+%define IDT_VECTOR_HAS_ERROR_CODE(vector) \
+  ((vector) == 8 || ((vector) >= 10 && (vector) <= 14) || (vector) == 17 || \
+   (vector) == 21 || (vector) == 29 || (vector) == 30)
+
+SECTION .text
+
+; Each stub pushes a zero in place of the error code where the processor
+; does not push one, and the vector, so that every vector ends up
+; with the same trap frame. This should match <include/idt/irq.h>.
+%assign vector 0
+%rep CONFIG_NUM_INTERRUPTS
+idt_stub_%[vector]:
+%if !IDT_VECTOR_HAS_ERROR_CODE(vector)
+  push 0
+%endif
+  push vector
+  jmp idt_common_entry
+%assign vector vector + 1
+%endrep
+
+; irq_dispatch takes the trap frame and the time stamp counter at entry,
+; which is only read with CONFIG_IRQ_STATS and zero otherwise.
+%ifdef CONFIG_X86_64
+; There is no pushad in long mode, so general registers are pushed one by one.
+; Processor aligns the stack before pushing the interrupt frame,
+; so the frame keeps it aligned to 16 bytes for the call.
+idt_common_entry:
+  push rax
+  push rbx
+  push rcx
+  push rdx
+  push rsi
+  push rdi
+  push rbp
+  push r8
+  push r9
+  push r10
+  push r11
+  push r12
+  push r13
+  push r14
+  push r15
+  cld
+  mov rdi, rsp
+%ifdef CONFIG_IRQ_STATS
+  rdtsc
+  shl rdx, 32
+  or rax, rdx
+  mov rsi, rax
+%else
+  xor esi, esi
+%endif
+  call irq_dispatch
+  pop r15
+  pop r14
+  pop r13
+  pop r12
+  pop r11
+  pop r10
+  pop r9
+  pop r8
+  pop rbp
+  pop rdi
+  pop rsi
+  pop rdx
+  pop rcx
+  pop rbx
+  pop rax
+  ; Vector and error code.
+  add rsp, 16
+  iretq
+%else
+idt_common_entry:
   pushad
-  call %2
+  cld
+  mov ebx, esp
+%ifdef CONFIG_IRQ_STATS
+  rdtsc
+%else
+  xor eax, eax
+  xor edx, edx
+%endif
+  push edx
+  push eax
+  push ebx
+  call irq_dispatch
+  add esp, 12
   popad
-  sti
+  ; Vector and error code.
+  add esp, 8
   iret
-%endmacro
+%endif
+
+SECTION .rodata
 
-define_interrupt_entrypoint irq_handler_entrypoint_timer, irq_handler_timer
-define_interrupt_entrypoint irq_handler_entrypoint_keyboard, irq_handler_keyboard
-define_interrupt_entrypoint irq_handler_entrypoint_primary_unknown, irq_handler_primary_unknown
-define_interrupt_entrypoint irq_handler_entrypoint_secondary_unknown, irq_handler_secondary_unknown
\ No newline at end of file
+; Entry of each vector, which is installed by <src/idt/idt.c>.
+align 8
+idt_stub_table:
+%assign vector 0
+%rep CONFIG_NUM_INTERRUPTS
+%ifdef CONFIG_X86_64
+  dq idt_stub_%[vector]
+%else
+  dd idt_stub_%[vector]
+%endif
+%assign vector vector + 1
+%endrep
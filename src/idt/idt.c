@@ -3,10 +3,17 @@
 
 #include <config.h>
 
+#include <apic/ioapic.h>
+#include <apic/lapic.h>
 #include <display/display.h>
+#include <idt/exception.h>
 #include <idt/idt.h>
+#include <idt/irq.h>
+#include <idt/irq_stats.h>
+#include <idt/softirq.h>
 #include <io/io.h>
 #include <memory/memory.h>
+#include <sched/sched.h>
 
 #define IDT_ATTR_GATETYPE_BIT_COUNT 4
 #define IDT_ATTR_RESERVED0_BIT_COUNT 1
@@ -30,6 +37,7 @@
 #define IDT_ATTR_PRESENT_BIT_MASK                                              \
   (((1U << IDT_ATTR_PRESENT_BIT_COUNT) - 1U) << IDT_ATTR_PRESENT_BIT_OFFSET)
 
+/* Same type stands for 64 bit interrupt gate in long mode. */
 #define IDT_ATTR_GATETYPE_INTERRUPT32 (0b1110U << IDT_ATTR_GATETYPE_BIT_OFFSET)
 #define IDT_ATTR_DPL_KERNEL (0U << IDT_ATTR_DPL_BIT_OFFSET)
 #define IDT_ATTR_DPL_USER (3U << IDT_ATTR_DPL_BIT_OFFSET)
@@ -127,24 +135,32 @@ struct __attribute__((packed)) idt_entry {
   uint8_t reserved;
   uint8_t attr;
   uint16_t handler_hi;
+#ifdef CONFIG_X86_64
+  uint32_t handler_upper;
+  uint32_t reserved_upper;
+#endif /* CONFIG_X86_64 */
 };
 
 struct __attribute__((packed)) idt_descriptor {
   uint16_t size;
-  uint32_t table;
+  uintptr_t table;
 };
 
 static struct idt_entry idt_table[CONFIG_NUM_INTERRUPTS];
 
-static inline void idt_set(struct idt_entry *entry, void (*handler)()) {
-  uint32_t handler32 = (uint32_t)handler;
+/* This is a table of entry stubs in <src/idt/idt.asm>. */
+extern const uintptr_t idt_stub_table[CONFIG_NUM_INTERRUPTS];
 
-  entry->handler_lo = (uint16_t)((handler32 & 0x0000ffffUL) >> 0);
+static inline void idt_set(struct idt_entry *entry, uintptr_t handler_addr) {
+  entry->handler_lo = (uint16_t)((handler_addr & 0x0000ffffUL) >> 0);
   entry->segment = KERNEL_CODE_SELECTOR;
   /* Only support 32 bit interrupt available to user for now. */
   entry->attr =
       IDT_ATTR_PRESENT_ON | IDT_ATTR_DPL_USER | IDT_ATTR_GATETYPE_INTERRUPT32;
-  entry->handler_hi = (uint16_t)((handler32 & 0xffff0000UL) >> 16);
+  entry->handler_hi = (uint16_t)((handler_addr & 0xffff0000UL) >> 16);
+#ifdef CONFIG_X86_64
+  entry->handler_upper = (uint32_t)(handler_addr >> 32);
+#endif /* CONFIG_X86_64 */
 }
 
 static inline void idt_load_descriptor(struct idt_entry *table,
@@ -158,19 +174,13 @@ static inline void idt_load_descriptor(struct idt_entry *table,
 
   struct idt_descriptor descriptor = {
       .size = (uint16_t)(sizeof(struct idt_entry) * interrupt_count - 1),
-      .table = (uint32_t)table,
+      .table = (uintptr_t)table,
   };
 
   // Reference: https://stackoverflow.com/questions/43577715/how-to-use-lidt-from-inline-assembly-to-load-an-interrupt-vector-table
   __asm__ inline("lidt %[descriptor]" : : [descriptor] "m"(descriptor));
 }
 
-static void interrupt_handler_divzero() {
-  terminal_print("Divide by zero.\n");
-  while (1) { /* Do not return since this does not iret. */
-  }
-}
-
 static void __idt_init_pic() {
   uint8_t primary_saved_mask;
   uint8_t secondary_saved_mask;
@@ -211,65 +221,125 @@ static void pic_notify_eoi(bool secondary) {
   x86_outb(X86_PIC_8259_PRIMARY_CONTROL_PORT, X86_PIC_8259_COMMAND_ACK);
 }
 
-void irq_handler_entrypoint_timer();
-void irq_handler_timer() {
-  const int IRQ_TIMER_LOG_COUNT_MAX = 5;
-  static int log_count = 0;
+static void pic_mask_all() {
+  x86_outb(X86_PIC_8259_PRIMARY_MASK_PORT, 0xFF);
+  x86_outb(X86_PIC_8259_SECONDARY_MASK_PORT, 0xFF);
+}
+
+/* ISA interrupts come from the I/O APIC instead of the 8259 when set. */
+static bool idt_apic_enabled;
 
-  if (log_count < IRQ_TIMER_LOG_COUNT_MAX) {
-    terminal_printk("timer interrupt: %d\n", log_count);
-    log_count++;
-  } else if (log_count == IRQ_TIMER_LOG_COUNT_MAX) {
-    terminal_print(
-        "Timer interrupt maximum log limit exceeded. Suppressing log from now on.\n");
-    log_count++;
+void irq_notify_eoi(const struct trap_frame *frame) {
+  if (idt_apic_enabled)
+    lapic_eoi();
+  else
+    pic_notify_eoi(frame->vector >= X86_PIC_EXCEPTION_8259_SECONDARY_BASE);
+}
+
+/**
+ * @brief Deliver ISA interrupts with handlers through the I/O APIC
+ * to the bootstrap processor, and mask the 8259.
+ *
+ * ISA interrupts keep the vectors they have on the 8259,
+ * so handlers do not care which one delivers them.
+ *
+ * @return int 0 on success, or -1 to stay on the 8259.
+ */
+static int __idt_init_apic() {
+  static const unsigned int isa_irqs[] = {
+      X86_IRQ_PRIMARY_OFFSET_TIMER_INTERRUPT,
+      X86_IRQ_PRIMARY_OFFSET_KEYBOARD_INTERRUPT,
+  };
+  uint32_t apic_id;
+
+  if (lapic_init() || ioapic_init())
+    return -1;
+
+  pic_mask_all();
+  lapic_enable();
+  apic_id = lapic_id();
+
+  for (size_t i = 0; i < sizeof(isa_irqs) / sizeof(isa_irqs[0]); ++i) {
+    if (ioapic_route_isa_irq(isa_irqs[i],
+                             X86_PIC_EXCEPTION_8259_PRIMARY_BASE + isa_irqs[i],
+                             apic_id))
+      terminal_printk("I/O APIC: ISA IRQ %u is not connected\n", isa_irqs[i]);
   }
 
-  pic_notify_eoi(false);
+  terminal_printk("Interrupts are delivered by the I/O APIC in %s mode\n",
+                  lapic_x2apic_enabled() ? "x2APIC" : "xAPIC");
+
+  idt_apic_enabled = true;
+  return 0;
 }
 
-void irq_handler_entrypoint_keyboard();
-void irq_handler_keyboard() {
+/* Scan codes with this bit are key releases. */
+#define X86_KBD_SCANCODE_RELEASE 0x80
+
+static uint8_t irq_keyboard_scancode;
+
+/**
+ * @brief Report the key press, which also dumps the scheduler statistics,
+ * and the interrupt statistics when they are compiled in.
+ */
+static void irq_work_keyboard(void *ctx) {
   terminal_print("irq_handler_keyboard\n");
-  pic_notify_eoi(false);
+
+  if (!(__atomic_load_n(&irq_keyboard_scancode, __ATOMIC_RELAXED) &
+        X86_KBD_SCANCODE_RELEASE)) {
+    irq_stats_dump();
+    sched_stats_dump();
+  }
 }
 
-void irq_handler_entrypoint_primary_unknown();
+static struct softirq_work irq_keyboard_work =
+    SOFTIRQ_WORK_INIT(irq_work_keyboard, NULL);
 
-void irq_handler_primary_unknown() {
-  x86_outb(X86_PIC_8259_PRIMARY_CONTROL_PORT, X86_PIC_8259_COMMAND_ACK);
-}
+static void irq_handler_keyboard(struct trap_frame *frame, void *ctx) {
+  /* Controller does not raise another interrupt until the data is read. */
+  __atomic_store_n(&irq_keyboard_scancode, x86_inb(X86_KBD_8259_DATA_PORT),
+                   __ATOMIC_RELAXED);
 
-void irq_handler_entrypoint_secondary_unknown();
+  irq_notify_eoi(frame);
+  softirq_queue_work(&irq_keyboard_work);
+}
 
-void irq_handler_secondary_unknown() {
-  x86_outb(X86_PIC_8259_PRIMARY_CONTROL_PORT, X86_PIC_8259_COMMAND_ACK);
+static void irq_handler_pic_unknown(struct trap_frame *frame, void *ctx) {
+  irq_notify_eoi(frame);
 }
 
+/* Spurious interrupts of the local APIC should not be acknowledged. */
+static void irq_handler_spurious(struct trap_frame *frame, void *ctx) {}
+
 void idt_init() {
   __idt_init_pic();
 
-  kmemset(idt_table, 0, sizeof(idt_table));
-  idt_set(&idt_table[0], interrupt_handler_divzero);
-
-  for (int interruptno = X86_PIC_EXCEPTION_8259_PRIMARY_BASE;
-       interruptno < X86_PIC_EXCEPTION_8259_PRIMARY_BASE +
-                         X86_PIC_EXCEPTION_8259_PRIMARY_COUNT;
+  /* Every vector goes through irq_dispatch. */
+  for (int interruptno = 0; interruptno < CONFIG_NUM_INTERRUPTS;
        ++interruptno) {
-    idt_set(&idt_table[interruptno], irq_handler_entrypoint_primary_unknown);
+    idt_set(&idt_table[interruptno], idt_stub_table[interruptno]);
   }
-  for (int interruptno = X86_PIC_EXCEPTION_8259_SECONDARY_BASE;
+
+  exception_init();
+
+  for (int interruptno = X86_PIC_EXCEPTION_8259_PRIMARY_BASE;
        interruptno < X86_PIC_EXCEPTION_8259_SECONDARY_BASE +
                          X86_PIC_EXCEPTION_8259_SECONDARY_COUNT;
        ++interruptno) {
-    idt_set(&idt_table[interruptno], irq_handler_entrypoint_secondary_unknown);
+    irq_register(interruptno, irq_handler_pic_unknown, NULL);
   }
 
-  idt_set(&idt_table[X86_IRQ_TIMER_INTERRUPT], irq_handler_entrypoint_timer);
-  idt_set(&idt_table[X86_IRQ_KEYBOARD_INTERRUPT],
-          irq_handler_entrypoint_keyboard);
+  irq_register(X86_IRQ_KEYBOARD_INTERRUPT, irq_handler_keyboard, NULL);
+  irq_register(LAPIC_SPURIOUS_VECTOR, irq_handler_spurious, NULL);
 
-  idt_load_descriptor(idt_table, sizeof(idt_table) / sizeof(idt_table[0]));
+  if (__idt_init_apic())
+    terminal_print("APIC is not available. Using the 8259 PIC.\n");
+
+  idt_load();
 
   x86_sti();
+}
+
+void idt_load() {
+  idt_load_descriptor(idt_table, sizeof(idt_table) / sizeof(idt_table[0]));
 }
\ No newline at end of file
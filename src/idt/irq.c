@@ -0,0 +1,58 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <config.h>
+#include <display/display.h>
+#include <idt/exception.h>
+#include <idt/irq.h>
+#include <idt/irq_stats.h>
+#include <idt/softirq.h>
+#include <sched/sched.h>
+
+struct irq_action {
+  irq_handler_t handler;
+  void *ctx;
+};
+
+static struct irq_action irq_actions[CONFIG_NUM_INTERRUPTS];
+
+int irq_register(unsigned int vector, irq_handler_t handler, void *ctx) {
+  if (vector >= CONFIG_NUM_INTERRUPTS)
+    return -1;
+
+  irq_actions[vector].ctx = ctx;
+  __atomic_store_n(&irq_actions[vector].handler, handler, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+void irq_unregister(unsigned int vector) {
+  if (vector >= CONFIG_NUM_INTERRUPTS)
+    return;
+
+  __atomic_store_n(&irq_actions[vector].handler, NULL, __ATOMIC_RELEASE);
+  irq_actions[vector].ctx = NULL;
+}
+
+/**
+ * @brief Entry of all vectors from <src/idt/idt.asm>.
+ */
+void irq_dispatch(struct trap_frame *frame, uint64_t entry_tsc) {
+  const struct irq_action *action = &irq_actions[frame->vector];
+  irq_handler_t handler =
+      __atomic_load_n(&action->handler, __ATOMIC_ACQUIRE);
+
+  if (handler == NULL)
+    terminal_printk("Unhandled interrupt %u\n", (unsigned int)frame->vector);
+  else
+    handler(frame, action->ctx);
+
+  irq_stats_record(frame->vector, entry_tsc);
+
+  /* Exceptions resume the faulting code right away, whatever its flags. */
+  if (frame->vector < X86_EXCEPTION_COUNT)
+    return;
+
+  softirq_irq_exit(frame);
+  sched_irq_exit(frame);
+}
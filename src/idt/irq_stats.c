@@ -0,0 +1,37 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <config.h>
+#include <cpu/percpu.h>
+#include <display/display.h>
+#include <idt/irq_stats.h>
+#include <smp/smp.h>
+
+DEFINE_PER_CPU(struct irq_stats, irq_stats);
+
+bool irq_stats_enabled = true;
+
+void irq_stats_set_enabled(bool enabled) {
+  __atomic_store_n(&irq_stats_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+void irq_stats_dump() {
+  /* Counters keep going while they are printed, so this is a rough view. */
+  for (unsigned int cpu = 0; cpu < smp_cpu_count(); ++cpu) {
+    const struct irq_stats *stats = per_cpu_ptr(irq_stats, cpu);
+
+    terminal_printk("CPU %u interrupts:", cpu);
+    for (unsigned int vector = 0; vector < CONFIG_NUM_INTERRUPTS; ++vector) {
+      if (stats->count[vector] != 0)
+        terminal_printk(" %02x=%u", vector, (unsigned int)stats->count[vector]);
+    }
+    terminal_print("\n");
+
+    terminal_printk("CPU %u latency (log2 cycles):", cpu);
+    for (unsigned int bucket = 0; bucket < IRQ_STATS_BUCKET_COUNT; ++bucket) {
+      if (stats->latency[bucket] != 0)
+        terminal_printk(" %u:%u", bucket, (unsigned int)stats->latency[bucket]);
+    }
+    terminal_print("\n");
+  }
+}
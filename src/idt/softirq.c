@@ -0,0 +1,119 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <idt/irq.h>
+#include <idt/softirq.h>
+#include <sched/preempt.h>
+
+/**
+ * Pending softirqs are run again at most this many times per interrupt,
+ * so that softirqs raised by interrupts in the meantime do not starve
+ * the interrupted code. The rest is left for the next interrupt.
+ */
+#define SOFTIRQ_RESTART_MAX 8
+
+DEFINE_PER_CPU(uint32_t, softirq_pending);
+static DEFINE_PER_CPU(bool, softirq_running);
+static DEFINE_PER_CPU(struct softirq_work *, softirq_work_list);
+
+static void softirq_run_work();
+
+static softirq_handler_t softirq_handlers[SOFTIRQ_COUNT] = {
+    [SOFTIRQ_WORK] = softirq_run_work,
+};
+
+void softirq_register(enum softirq nr, softirq_handler_t handler) {
+  softirq_handlers[nr] = handler;
+}
+
+bool softirq_queue_work(struct softirq_work *work) {
+  unsigned long flags;
+
+  if (__atomic_exchange_n(&work->queued, true, __ATOMIC_ACQUIRE))
+    return false;
+
+  flags = x86_irq_save();
+  work->next = this_cpu_read(softirq_work_list);
+  this_cpu_write(softirq_work_list, work);
+  softirq_raise(SOFTIRQ_WORK);
+  x86_irq_restore(flags);
+
+  return true;
+}
+
+static void softirq_run_work() {
+  struct softirq_work *list, *fifo = NULL;
+
+  x86_irq_disable();
+  list = this_cpu_read(softirq_work_list);
+  this_cpu_write(softirq_work_list, NULL);
+  x86_irq_enable();
+
+  /* Work is pushed in front, so reverse it to run in order of queueing. */
+  while (list != NULL) {
+    struct softirq_work *next = list->next;
+
+    list->next = fifo;
+    fifo = list;
+    list = next;
+  }
+
+  while (fifo != NULL) {
+    struct softirq_work *work = fifo;
+
+    fifo = work->next;
+    __atomic_store_n(&work->queued, false, __ATOMIC_RELEASE);
+    work->fn(work->ctx);
+  }
+}
+
+/**
+ * @brief Run pending softirqs, entered and left with interrupts disabled.
+ */
+static void softirq_run() {
+  this_cpu_write(softirq_running, true);
+  /* Interrupts nested in softirqs should not switch threads. */
+  preempt_disable();
+
+  for (int restart = 0; restart < SOFTIRQ_RESTART_MAX; ++restart) {
+    uint32_t pending = this_cpu_read(softirq_pending);
+
+    if (pending == 0)
+      break;
+    this_cpu_write(softirq_pending, 0);
+
+    x86_irq_enable();
+    while (pending != 0) {
+      const unsigned int nr = (unsigned int)__builtin_ctz(pending);
+
+      pending &= pending - 1;
+      if (softirq_handlers[nr] != NULL)
+        softirq_handlers[nr]();
+    }
+    x86_irq_disable();
+  }
+
+  preempt_enable();
+  this_cpu_write(softirq_running, false);
+}
+
+void softirq_irq_exit(const struct trap_frame *frame) {
+  if (!(trap_frame_flags(frame) & X86_EFLAGS_IF) ||
+      this_cpu_read(softirq_running))
+    return;
+
+  softirq_run();
+}
+
+void softirq_run_pending() {
+  const unsigned long flags = x86_irq_save();
+
+  if ((flags & X86_EFLAGS_IF) && !this_cpu_read(softirq_running) &&
+      this_cpu_read(softirq_pending) != 0)
+    softirq_run();
+
+  x86_irq_restore(flags);
+}
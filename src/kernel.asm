@@ -1,29 +1,418 @@
 BITS 32
 
 EXTERN kernel_main
+EXTERN smp_ap_main
+EXTERN smp_ap_boot_stack
+EXTERN smp_ap_boot_cpu
 
 GLOBAL _start
 GLOBAL kernel_start
+GLOBAL kernel_start_ap
+GLOBAL kernel_start_tsc
+%ifdef CONFIG_X86_64
+GLOBAL kernel_pml4
+%else
+GLOBAL kernel_page_directory
+%endif
 
-_start:
-kernel_start:
+; Multiboot headers let the kernel be loaded directly, such as qemu -kernel.
+; QEMU only supports Multiboot 1, while GRUB supports both.
+; See also: <include/boot/multiboot.h>
+%define MULTIBOOT_HEADER_MAGIC 0x1BADB002
+; Align modules to page, and provide the memory map
+%define MULTIBOOT_HEADER_FLAGS 0x00000003
 
-.setup_stack:
+%define MULTIBOOT2_HEADER_MAGIC 0xE85250D6
+%define MULTIBOOT2_ARCHITECTURE_I386 0
 
-%define STACK_BASE_ADDR 0x00200000 ; 2M
+; This should match <include/config.h>.
+%define KERNEL_CODE_SELECTOR 0x08
+%define KERNEL_DATA_SELECTOR 0x10
 
-  mov ebp, STACK_BASE_ADDR
-  mov esp, ebp
+; This should match <include/memory/paging.h>.
+%ifdef CONFIG_X86_64
+%define KERNEL_VIRTUAL_BASE 0xFFFFFFFFC0000000
+%define PAGING_LARGE_PAGE_SHIFT 21
+%define PAGING_DIRECTORY_ENTRY_COUNT 512
+%else
+%define KERNEL_VIRTUAL_BASE 0xC0000000
+%define PAGING_LARGE_PAGE_SHIFT 22
+%define PAGING_DIRECTORY_ENTRY_COUNT 1024
+%endif
+%define KERNEL_VIRTUAL_SIZE 0x10000000
+%define PAGING_IDENTITY_LIMIT 0xC0000000
+%define PAGING_MMIO_BASE 0xD0000000
+%define PAGING_PDE_PRESENT (1 << 0)
+%define PAGING_PDE_WRITE (1 << 1)
+%define PAGING_PDE_WRITE_THROUGH (1 << 3)
+%define PAGING_PDE_CACHE_DISABLE (1 << 4)
+%define PAGING_PDE_LARGE (1 << 7)
+%define PAGING_PDE_GLOBAL (1 << 8)
+
+%define PAGING_IDENTITY_PDE_COUNT (PAGING_IDENTITY_LIMIT >> PAGING_LARGE_PAGE_SHIFT)
+%define PAGING_MMIO_PDE_INDEX (PAGING_MMIO_BASE >> PAGING_LARGE_PAGE_SHIFT)
+%define PAGING_KERNEL_PDE_COUNT (KERNEL_VIRTUAL_SIZE >> PAGING_LARGE_PAGE_SHIFT)
+
+%define X86_CR0_WP (1 << 16)
+%define X86_CR0_PG (1 << 31)
+%define X86_CR4_PSE (1 << 4)
+%define X86_CR4_PAE (1 << 5)
+%define X86_CR4_PGE (1 << 7)
+
+%define X86_CPUID_EXTENDED_MAX 0x80000000
+%define X86_CPUID_EXTENDED_FEATURE 0x80000001
+%define X86_CPUID_EXTENDED_EDX_LM (1 << 29)
+
+%define X86_MSR_EFER 0xC0000080
+%define X86_EFER_LME (1 << 8)
+
+SECTION .multiboot progbits alloc noexec nowrite align=8
+
+multiboot_header:
+  dd MULTIBOOT_HEADER_MAGIC
+  dd MULTIBOOT_HEADER_FLAGS
+  dd 0x100000000 - (MULTIBOOT_HEADER_MAGIC + MULTIBOOT_HEADER_FLAGS)
+
+align 8
+multiboot2_header_start:
+  dd MULTIBOOT2_HEADER_MAGIC
+  dd MULTIBOOT2_ARCHITECTURE_I386
+  dd multiboot2_header_end - multiboot2_header_start
+  dd 0x100000000 - (MULTIBOOT2_HEADER_MAGIC + MULTIBOOT2_ARCHITECTURE_I386 + (multiboot2_header_end - multiboot2_header_start))
+  ; End tag
+  dw 0, 0
+  dd 8
+multiboot2_header_end:
+
+; Code here runs at the physical address, until paging is enabled.
+; Everything else is linked to the higher half, so it should be
+; accessed by physical address in the meantime.
+SECTION .boot.text progbits alloc exec nowrite align=16
+
+; Kernel is entered in protected mode with paging disabled,
+; either from stage 2 or from a Multiboot loader.
+; eax holds the magic of the boot protocol, and ebx holds the boot information.
+_start:
+kernel_start:
+  mov esi, eax
+  mov edi, ebx
+
+.stamp_boot_timeline:
+  rdtsc
+  mov [kernel_start_tsc - KERNEL_VIRTUAL_BASE], eax
+  mov [kernel_start_tsc - KERNEL_VIRTUAL_BASE + 4], edx
 
 .enable_a20_line:
-  ; Enable the A20 line
+  ; Enable the A20 line, before anything above 1M is accessed by the MMU
   in al, 0x92
   or al, 0x02
   out 0x92, al
 
+%ifdef CONFIG_X86_64
+
+.check_long_mode:
+  mov eax, X86_CPUID_EXTENDED_MAX
+  cpuid
+  cmp eax, X86_CPUID_EXTENDED_FEATURE
+  jb .long_mode_not_supported
+
+  mov eax, X86_CPUID_EXTENDED_FEATURE
+  cpuid
+  test edx, X86_CPUID_EXTENDED_EDX_LM
+  jz .long_mode_not_supported
+
+.enable_paging:
+  ; Page tables are static, since only 2 MiB pages are used.
+  mov eax, cr4
+  or eax, X86_CR4_PAE | X86_CR4_PGE
+  mov cr4, eax
+
+  mov eax, kernel_pml4 - KERNEL_VIRTUAL_BASE
+  mov cr3, eax
+
+  mov ecx, X86_MSR_EFER
+  rdmsr
+  or eax, X86_EFER_LME
+  wrmsr
+
+  mov eax, cr0
+  or eax, X86_CR0_PG | X86_CR0_WP
+  mov cr0, eax
+
+  ; Processor stays in compatibility mode until a 64 bit code segment is loaded.
+  lgdt [kernel_boot_gdt_descriptor]
+  jmp KERNEL_CODE_SELECTOR:.enter_long_mode
+
+.long_mode_not_supported:
+  ; Terminal is not available yet, so write to video memory directly.
+  mov esi, kernel_long_mode_message
+  mov edi, 0xB8000
+  mov ah, 0x04
+.print_message:
+  lodsb
+  test al, al
+  jz .halt
+  stosw
+  jmp .print_message
+.halt:
+  cli
+  hlt
+  jmp .halt
+
+BITS 64
+.enter_long_mode:
+  ; Jump is absolute, so it lands in the higher half.
+  mov rax, kernel_start_higher_half
+  jmp rax
+
+BITS 32
+
+kernel_long_mode_message:
+  db "Kernel is built for x86-64, but long mode is not supported.", 0
+
+; GDT of the kernel is linked to the higher half, so this one is used to enter long mode.
+align 8
+kernel_boot_gdt_start:
+  dd 0x00000000
+  dd 0x00000000
+
+  dw 0xffff, 0x0000
+  db 0x00, 0x9b, 0xaf, 0x00
+
+  dw 0xffff, 0x0000
+  db 0x00, 0x93, 0xcf, 0x00
+kernel_boot_gdt_end:
+
+kernel_boot_gdt_descriptor:
+  dw kernel_boot_gdt_end - kernel_boot_gdt_start - 1
+  dd kernel_boot_gdt_start
+
+%else
+
+.enable_paging:
+  ; Page directory is static, since only 4 MiB pages are used.
+  mov eax, cr4
+  or eax, X86_CR4_PSE | X86_CR4_PGE
+  mov cr4, eax
+
+  mov eax, kernel_page_directory - KERNEL_VIRTUAL_BASE
+  mov cr3, eax
+
+  mov eax, cr0
+  or eax, X86_CR0_PG | X86_CR0_WP
+  mov cr0, eax
+
+  ; Jump is absolute, so it lands in the higher half.
+  mov eax, kernel_start_higher_half
+  jmp eax
+
+%endif
+
+SECTION .text
+
+%ifdef CONFIG_X86_64
+
+BITS 64
+
+; Code segment cannot be reloaded with a far jump in long mode,
+; so a far return does it instead.
+%macro reload_segments 0
+  lgdt [rel kernel_gdt_descriptor]
+  push KERNEL_CODE_SELECTOR
+  lea rax, [rel %%setup_data_segment_selector]
+  push rax
+  retfq
+%%setup_data_segment_selector:
+  mov ax, KERNEL_DATA_SELECTOR
+  mov ds, ax
+  mov es, ax
+  mov fs, ax
+  mov gs, ax
+  mov ss, ax
+%endmacro
+
+%else
+
+%macro reload_segments 0
+  lgdt [kernel_gdt_descriptor]
+  jmp KERNEL_CODE_SELECTOR:%%setup_data_segment_selector
+%%setup_data_segment_selector:
+  mov ax, KERNEL_DATA_SELECTOR
+  mov ds, ax
+  mov es, ax
+  mov fs, ax
+  mov gs, ax
+  mov ss, ax
+%endmacro
+
+%endif
+
+kernel_start_higher_half:
+
+.setup_gdt:
+  ; GDT from the Multiboot loader should not be relied upon.
+  reload_segments
+
+.setup_stack:
+%ifdef CONFIG_X86_64
+  mov rbp, kernel_boot_stack_top
+  mov rsp, rbp
+
+  ; Arguments are passed in edi and esi instead.
+  mov eax, edi
+  mov edi, esi
+  mov esi, eax
+%else
+  mov ebp, kernel_boot_stack_top
+  mov esp, ebp
+
+  push edi
+  push esi
+%endif
   call kernel_main
 
   jmp $
 
-; Align to sector granularity to avoid alignment issues
-times 511 - ($-$$+511) % 512 db 0
\ No newline at end of file
+; Application processors come here from <src/smp/trampoline.asm>,
+; with paging already enabled.
+kernel_start_ap:
+  reload_segments
+
+.setup_stack:
+  ; Each processor has its own stack, allocated by <src/smp/smp.c>.
+%ifdef CONFIG_X86_64
+  mov rbp, [rel smp_ap_boot_stack]
+  mov rsp, rbp
+
+  mov edi, [rel smp_ap_boot_cpu]
+%else
+  mov ebp, [smp_ap_boot_stack]
+  mov esp, ebp
+
+  push dword [smp_ap_boot_cpu]
+%endif
+  call smp_ap_main
+
+  jmp $
+
+SECTION .rodata
+
+align 8
+
+kernel_gdt_start:
+kernel_gdt_entry_null:
+  dd 0x00000000
+  dd 0x00000000
+
+kernel_gdt_entry_code:
+  dw 0xffff, 0x0000
+%ifdef CONFIG_X86_64
+  ; Long mode code segment, where the default operand size is still 32 bit.
+  db 0x00, 0x9b, 0xaf, 0x00
+%else
+  db 0x00, 0x9b, 0xcf, 0x00
+%endif
+
+kernel_gdt_entry_data:
+  dw 0xffff, 0x0000
+  db 0x00, 0x93, 0xcf, 0x00
+kernel_gdt_end:
+
+kernel_gdt_descriptor:
+  dw kernel_gdt_end - kernel_gdt_start - 1 ; Subtracted by 1 due to architecture design
+%ifdef CONFIG_X86_64
+  dq kernel_gdt_start
+%else
+  dd kernel_gdt_start
+%endif
+
+SECTION .data
+
+; Entries are generated here, and the layout is described in <include/memory/paging.h>.
+%ifdef CONFIG_X86_64
+
+align 4096
+kernel_pml4:
+  dq (kernel_pdpt_low - KERNEL_VIRTUAL_BASE) + (PAGING_PDE_PRESENT | PAGING_PDE_WRITE)
+  times PAGING_DIRECTORY_ENTRY_COUNT - 2 dq 0
+  ; Last entry covers the top 512G, where the kernel is.
+  dq (kernel_pdpt_high - KERNEL_VIRTUAL_BASE) + (PAGING_PDE_PRESENT | PAGING_PDE_WRITE)
+
+align 4096
+kernel_pdpt_low:
+%assign pdpte_index 0
+%rep 4
+  dq (kernel_pd_low - KERNEL_VIRTUAL_BASE + (pdpte_index << 12)) + (PAGING_PDE_PRESENT | PAGING_PDE_WRITE)
+%assign pdpte_index pdpte_index + 1
+%endrep
+  times PAGING_DIRECTORY_ENTRY_COUNT - 4 dq 0
+
+align 4096
+kernel_pdpt_high:
+  times PAGING_DIRECTORY_ENTRY_COUNT - 1 dq 0
+  ; Last entry covers the top 1G, which starts at KERNEL_VIRTUAL_BASE.
+  dq (kernel_pd_high - KERNEL_VIRTUAL_BASE) + (PAGING_PDE_PRESENT | PAGING_PDE_WRITE)
+
+; Four page directories for the low 4G
+align 4096
+kernel_pd_low:
+%assign pde_index 0
+%rep 4 * PAGING_DIRECTORY_ENTRY_COUNT
+%if pde_index < PAGING_IDENTITY_PDE_COUNT
+  ; Identity map for RAM
+  dq (pde_index << PAGING_LARGE_PAGE_SHIFT) | PAGING_PDE_PRESENT | PAGING_PDE_WRITE | PAGING_PDE_LARGE
+%elif pde_index < PAGING_MMIO_PDE_INDEX
+  ; Kernel is not here in long mode
+  dq 0
+%else
+  ; Identity map for MMIO, which should not be cached
+  dq (pde_index << PAGING_LARGE_PAGE_SHIFT) | PAGING_PDE_PRESENT | PAGING_PDE_WRITE | PAGING_PDE_WRITE_THROUGH | PAGING_PDE_CACHE_DISABLE | PAGING_PDE_LARGE
+%endif
+%assign pde_index pde_index + 1
+%endrep
+
+align 4096
+kernel_pd_high:
+%assign pde_index 0
+%rep PAGING_KERNEL_PDE_COUNT
+  ; Kernel in the higher half, which is shared by every address space
+  dq (pde_index << PAGING_LARGE_PAGE_SHIFT) | PAGING_PDE_PRESENT | PAGING_PDE_WRITE | PAGING_PDE_LARGE | PAGING_PDE_GLOBAL
+%assign pde_index pde_index + 1
+%endrep
+  times PAGING_DIRECTORY_ENTRY_COUNT - PAGING_KERNEL_PDE_COUNT dq 0
+
+%else
+
+align 4096
+kernel_page_directory:
+%assign pde_index 0
+%rep PAGING_DIRECTORY_ENTRY_COUNT
+%if pde_index < PAGING_IDENTITY_PDE_COUNT
+  ; Identity map for RAM
+  dd (pde_index << PAGING_LARGE_PAGE_SHIFT) | PAGING_PDE_PRESENT | PAGING_PDE_WRITE | PAGING_PDE_LARGE
+%elif pde_index < PAGING_MMIO_PDE_INDEX
+  ; Kernel in the higher half, which is shared by every address space
+  dd ((pde_index - PAGING_IDENTITY_PDE_COUNT) << PAGING_LARGE_PAGE_SHIFT) | PAGING_PDE_PRESENT | PAGING_PDE_WRITE | PAGING_PDE_LARGE | PAGING_PDE_GLOBAL
+%else
+  ; Identity map for MMIO, which should not be cached
+  dd (pde_index << PAGING_LARGE_PAGE_SHIFT) | PAGING_PDE_PRESENT | PAGING_PDE_WRITE | PAGING_PDE_WRITE_THROUGH | PAGING_PDE_CACHE_DISABLE | PAGING_PDE_LARGE
+%endif
+%assign pde_index pde_index + 1
+%endrep
+
+%endif
+
+SECTION .bss
+
+; Stack of the bootstrap processor, which becomes its idle thread.
+; It is part of the kernel image, so memory after the image is free.
+%define KERNEL_BOOT_STACK_SIZE 0x4000
+
+alignb 16
+kernel_boot_stack:
+  resb KERNEL_BOOT_STACK_SIZE
+kernel_boot_stack_top:
+
+; Read by <src/time/boot_timeline.c>.
+kernel_start_tsc:
+  resq 1
@@ -1,27 +1,220 @@
 #include <stdint.h>
 
+#include <acpi/acpi.h>
+#include <acpi/madt.h>
+#include <base.h>
+#include <boot/bootinfo.h>
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
 #include <display/display.h>
 #include <idt/idt.h>
 #include <kernel.h>
+#include <memory/memmap.h>
+#include <sched/sched.h>
+#include <sched/task.h>
+#include <smp/smp.h>
+#include <time/boot_timeline.h>
+#include <time/clockevent.h>
+#include <time/ktime.h>
+#include <time/timer.h>
 
 #ifdef TEST_VCBPRINTF
 #include <display/vcbprintf_test.h>
 #endif /* TEST_VCBPRINTF */
 
-void kernel_main() {
+/* Timer events logged on the bootstrap processor before it goes idle. */
+#define KERNEL_TIMER_LOG_COUNT 5
+#define KERNEL_TIMER_INTERVAL_NS (100U * NSEC_PER_MSEC)
+
+static struct timer kernel_timer;
+static int kernel_timer_log_count;
+
+/**
+ * @brief Log timer events, each adding the timer again up to the limit.
+ */
+static void kernel_timer_log(void *ctx) {
+  terminal_printk("timer event: %d\n", kernel_timer_log_count);
+
+  if (++kernel_timer_log_count < KERNEL_TIMER_LOG_COUNT)
+    timer_add(&kernel_timer, ktime_get_ns() + KERNEL_TIMER_INTERVAL_NS,
+              kernel_timer_log, NULL);
+  else
+    terminal_print("No more timer events. Staying idle from now on.\n");
+}
+
+/* Busy threads started at boot, which take turns on the processor. */
+#define KERNEL_THREAD_COUNT 2
+#define KERNEL_THREAD_ROUNDS 3
+#define KERNEL_THREAD_WORK_NS (30U * NSEC_PER_MSEC)
+
+/**
+ * @brief Spin through a few rounds of work, each longer than a slice,
+ * so that the thread is preempted in the middle of them.
+ */
+static void kernel_thread_busy(void *ctx) {
+  const unsigned int id = (unsigned int)(uintptr_t)ctx;
+
+  for (int round = 0; round < KERNEL_THREAD_ROUNDS; ++round) {
+    const uint64_t until = ktime_get_ns() + KERNEL_THREAD_WORK_NS;
+
+    while (ktime_get_ns() < until)
+      x86_pause();
+    terminal_printk("thread %u: round %d\n", id, round);
+  }
+}
+
+/**
+ * Requests which overlap without a thread each, completed by timers
+ * in place of a device interrupt.
+ */
+#define KERNEL_REQUEST_COUNT 3
+#define KERNEL_REQUEST_STEPS 2
+#define KERNEL_REQUEST_LATENCY_NS (20U * NSEC_PER_MSEC)
+
+struct kernel_request {
+  struct task task;
+  struct future done;
+  struct timer device;
+  unsigned int id;
+  int step;
+};
+
+static struct kernel_request kernel_requests[KERNEL_REQUEST_COUNT];
+
+static void kernel_request_complete(void *ctx) {
+  struct kernel_request *request = ctx;
+
+  future_complete(&request->done, request->step);
+}
+
+/**
+ * @brief Continuation of a request, which reports the step just completed
+ * and starts the next one.
+ */
+static void kernel_request_step(struct task *task) {
+  struct kernel_request *request =
+      container_of(task, struct kernel_request, task);
+
+  if (request->step > 0)
+    terminal_printk("request %u: step %d done\n", request->id,
+                    future_result(&request->done));
+  if (request->step == KERNEL_REQUEST_STEPS)
+    return;
+
+  request->step++;
+  future_init(&request->done);
+  timer_add(&request->device,
+            ktime_get_ns() + (request->id + 1) * KERNEL_REQUEST_LATENCY_NS,
+            kernel_request_complete, request);
+  future_then(&request->done, task);
+}
+
+static void kernel_report_boot_info() {
+  const struct boot_info *info = kernel_boot_info();
+
+  if (!boot_info_valid(info)) {
+    terminal_print("Boot information is not available.\n");
+    return;
+  }
+
+  if (info->flags & BOOT_INFO_FLAG_MULTIBOOT) {
+    terminal_printk("Booted by Multiboot loader with command line \"%s\"\n",
+                    info->cmdline);
+
+    for (uint32_t i = 0; i < info->module_count; ++i)
+      terminal_printk("Module %u: %08x-%08x \"%s\"\n", (unsigned int)i,
+                      (unsigned int)info->modules[i].start,
+                      (unsigned int)info->modules[i].end,
+                      info->modules[i].cmdline);
+  }
+
+  if (info->flags & BOOT_INFO_FLAG_FRAMEBUFFER)
+    terminal_printk("Framebuffer: %ux%ux%u at %016llx\n",
+                    (unsigned int)info->framebuffer.width,
+                    (unsigned int)info->framebuffer.height,
+                    (unsigned int)info->framebuffer.bpp,
+                    (unsigned long long)info->framebuffer.addr);
+
+  if (info->flags & BOOT_INFO_FLAG_KERNEL_LZ4) {
+    /* Avoid 64 bit division, which is not available without libgcc. */
+    unsigned int percent = info->kernel_lz4.uncompressed_size >= 100
+                               ? info->kernel_lz4.compressed_size /
+                                     (info->kernel_lz4.uncompressed_size / 100)
+                               : 100;
+
+    terminal_printk("Kernel decompressed from %u to %u bytes (%u%%) "
+                    "in %llu cycles\n",
+                    (unsigned int)info->kernel_lz4.compressed_size,
+                    (unsigned int)info->kernel_lz4.uncompressed_size, percent,
+                    (unsigned long long)info->kernel_lz4.decode_cycles);
+  }
+}
+
+void kernel_main(uint32_t boot_magic, uint32_t boot_addr) {
+  percpu_init();
+
+  boot_info_init(boot_magic, boot_addr);
+  boot_timeline_init();
 
   terminal_init();
+  boot_timeline_stamp(BOOT_PHASE_TERMINAL_INIT);
+
+  kernel_report_boot_info();
+
+  memmap_init();
+  boot_timeline_stamp(BOOT_PHASE_MEMMAP_INIT);
 
   terminal_print("Hello from kernel!\n");
   terminal_print("Hello from kernel!\n");
   terminal_print("Hello from kernel!\rHello from second line!\n");
 
+  /* Interrupt controllers are found through the MADT. */
+  if (acpi_init() || madt_init())
+    terminal_print("ACPI tables are not available.\n");
+
+  /* Interrupts are not enabled yet, which keeps the calibration steady. */
+  if (ktime_init())
+    terminal_print("TSC calibration failed. Time is not available.\n");
+  boot_timeline_stamp(BOOT_PHASE_KTIME_INIT);
+
   idt_init();
+  boot_timeline_stamp(BOOT_PHASE_IDT_INIT);
+
+  timer_init();
+  executor_init();
+  if (clockevent_init())
+    terminal_print("Timer events are not available.\n");
+  sched_init();
+
+  smp_init();
+  boot_timeline_stamp(BOOT_PHASE_SMP_INIT);
+
+  boot_timeline_print();
 
 #ifdef TEST_VCBPRINTF
   vcbprintf_test();
 #endif
 
-  while (1) {
+  timer_add(&kernel_timer, ktime_get_ns() + KERNEL_TIMER_INTERVAL_NS,
+            kernel_timer_log, NULL);
+
+  for (unsigned int i = 0; i < KERNEL_THREAD_COUNT; ++i) {
+    if (thread_create(kernel_thread_busy, (void *)(uintptr_t)i) == NULL)
+      terminal_printk("Cannot start thread %u.\n", i);
   }
-}
\ No newline at end of file
+
+  for (unsigned int i = 0; i < KERNEL_REQUEST_COUNT; ++i) {
+    kernel_requests[i].id = i;
+    task_init(&kernel_requests[i].task, kernel_request_step);
+    task_schedule(&kernel_requests[i].task);
+  }
+
+  /* Boot is done, so this becomes the idle thread. */
+  sched_idle();
+}
+
+void kernel_main_ap(unsigned int cpu) {
+  terminal_printk("Hello from CPU %u!\n", cpu);
+
+  sched_idle();
+}
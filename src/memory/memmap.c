@@ -0,0 +1,115 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boot/bootinfo.h>
+#include <boot/e820.h>
+#include <display/display.h>
+#include <memory/memmap.h>
+#include <memory/page_alloc.h>
+#include <memory/paging.h>
+
+/**
+ * This is a symbol in <src/script.ld>, where only the address matters.
+ * Note that this is a physical address.
+ */
+extern char KERNEL_RUNTIME_END[];
+
+/* Pages are handed out by physical address, which is identity mapped. */
+#define MEMMAP_ADDR_LIMIT ((uint64_t)PAGING_IDENTITY_LIMIT)
+
+static const char *memmap_type_name(uint32_t type) {
+  switch (type) {
+  case E820_TYPE_USABLE:
+    return "usable";
+  case E820_TYPE_ACPI_RECLAIMABLE:
+    return "ACPI reclaimable";
+  case E820_TYPE_ACPI_NVS:
+    return "ACPI NVS";
+  case E820_TYPE_BAD:
+    return "bad";
+  default:
+    return "reserved";
+  }
+}
+
+/**
+ * @brief Register the part of the range not used by boot modules.
+ *
+ * @return uint64_t Size of memory registered.
+ */
+static uint64_t memmap_register_range(const struct boot_info *info,
+                                      uint64_t start, uint64_t end,
+                                      uint32_t module_index) {
+  uint64_t size = 0;
+  int ret;
+
+  for (; module_index < info->module_count; ++module_index) {
+    const uint64_t module_start =
+        info->modules[module_index].start & ~(uint64_t)PAGE_MASK;
+    const uint64_t module_end =
+        ((uint64_t)info->modules[module_index].end + PAGE_MASK) &
+        ~(uint64_t)PAGE_MASK;
+
+    if (module_end <= start || end <= module_start)
+      continue;
+
+    /* Modules are left in place, so register around it. */
+    if (start < module_start)
+      size += memmap_register_range(info, start, module_start,
+                                    module_index + 1);
+    if (module_end < end)
+      size += memmap_register_range(info, module_end, end, module_index + 1);
+
+    return size;
+  }
+
+  if (start >= end || end - start < 2 * PAGE_SIZE)
+    return 0;
+
+  ret = register_region((void *)(uintptr_t)start, (size_t)(end - start));
+  if (ret) {
+    terminal_printk("Failed to register memory at %016llx (%d).\n",
+                    (unsigned long long)start, ret);
+    return 0;
+  }
+
+  return end - start;
+}
+
+void memmap_init() {
+  const struct boot_info *info = kernel_boot_info();
+  uint64_t low = (uintptr_t)KERNEL_RUNTIME_END;
+  uint64_t usable_size = 0, registered_size = 0;
+
+  if (!boot_info_valid(info) || !(info->flags & BOOT_INFO_FLAG_E820)) {
+    terminal_print("Memory map is not available.\n");
+    return;
+  }
+
+  for (uint32_t i = 0; i < info->e820_count; ++i) {
+    const struct e820_entry *entry = &info->e820[i];
+    uint64_t start = entry->base, end = entry->base + entry->length;
+
+    terminal_printk("e820: %016llx-%016llx %s\n", (unsigned long long)start,
+                    (unsigned long long)end, memmap_type_name(entry->type));
+
+    if (entry->type != E820_TYPE_USABLE)
+      continue;
+
+    usable_size += entry->length;
+
+    if (start < low)
+      start = low;
+    if (end > MEMMAP_ADDR_LIMIT)
+      end = MEMMAP_ADDR_LIMIT;
+
+    start = (start + PAGE_MASK) & ~(uint64_t)PAGE_MASK;
+    end &= ~(uint64_t)PAGE_MASK;
+
+    registered_size += memmap_register_range(info, start, end, 0);
+  }
+
+  terminal_printk("Memory: %u KiB usable, %u KiB given to the page allocator\n",
+                  (unsigned int)(usable_size >> 10),
+                  (unsigned int)(registered_size >> 10));
+}
@@ -0,0 +1,573 @@
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <memory/page_alloc.h>
+#include <sync/spinlock.h>
+
+/**
+ * Buddy page allocator, ported from <test/memory/simplealloc.cpp>.
+ *
+ * The memory map of each registered region is placed at the tail of the region,
+ * so nothing needs to be allocated before the first region is registered.
+ */
+
+#ifndef MAX_NUM_REGIONS
+#define MAX_NUM_REGIONS 8U
+#endif /* MAX_NUM_REGIONS */
+
+#ifndef MAX_BLOCK_ORDER
+#define MAX_BLOCK_ORDER 16U
+#endif /* MAX_BLOCK_ORDER */
+
+#ifndef container_of
+#define container_of(ptr, type, member)                                        \
+  ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif /* container_of */
+
+namespace {
+
+#define OOKBugOn(value)                                                        \
+  do {                                                                         \
+    if (0) {                                                                   \
+      (void)(value);                                                           \
+    }                                                                          \
+  } while (0)
+
+template <typename UnsignedType> inline constexpr unsigned int bitwidth() {
+  static_assert(std::is_unsigned<UnsignedType>::value);
+
+  return CHAR_BIT * sizeof(UnsignedType);
+}
+
+template <typename UnsignedType>
+inline constexpr unsigned int log2floor(const UnsignedType x) {
+  static_assert(std::is_unsigned<UnsignedType>::value);
+
+  if (x == 0)
+    return 0;
+
+  for (unsigned int nb = 0; nb < CHAR_BIT * sizeof(x); ++nb) {
+    if ((x >> nb) == 1)
+      return nb;
+  }
+
+  /* Never reached. */
+  return std::numeric_limits<unsigned int>::max();
+}
+
+template <typename UnsignedType>
+inline constexpr unsigned int log2ceil(const UnsignedType x) {
+  static_assert(std::is_unsigned<UnsignedType>::value);
+
+  if (x <= 1)
+    return 0;
+
+  return 1 + log2floor(x - 1);
+
+  /* Never reached. */
+  return std::numeric_limits<unsigned int>::max();
+}
+
+template <typename UnsignedType>
+inline constexpr unsigned int ctz(const UnsignedType x) {
+  static_assert(std::is_unsigned<UnsignedType>::value);
+
+  if (x == 0)
+    return CHAR_BIT * sizeof(UnsignedType);
+
+  return log2floor(x & -x);
+}
+
+
+struct list_head {
+  struct list_head *prev = this;
+  struct list_head *next = this;
+
+  constexpr list_head() { reset(); }
+
+  void add(struct list_head *e) {
+    struct list_head *next = this->next;
+
+    this->next = next->prev = e;
+    e->prev = this;
+    e->next = next;
+  }
+
+  void add_tail(struct list_head *e) { this->prev->add(e); }
+
+  void remove() {
+    struct list_head *prev = this->prev;
+    struct list_head *next = this->next;
+
+    prev->next = next;
+    next->prev = prev;
+
+    reset();
+  }
+
+  bool empty() { return (this->next == this); }
+
+  constexpr void reset() { this->prev = this->next = this; }
+};
+
+struct ookpage {
+  void *addr;
+  size_t size;
+  struct list_head list;
+};
+
+static_assert((sizeof(struct ookpage) & (sizeof(struct ookpage) - 1)) == 0);
+constexpr unsigned int OOKPAGE_SIZE_SHIFT = log2ceil(sizeof(struct ookpage));
+static_assert(OOKPAGE_SIZE_SHIFT < bitwidth<unsigned int>() &&
+              sizeof(struct ookpage) == (1UL << OOKPAGE_SIZE_SHIFT));
+
+struct OOKRegion {
+  enum {
+    OOKREGION_STATE_REGISTERED = 1 << 0,
+  };
+
+  void *addr = nullptr;
+  size_t size = 0;
+  struct ookpage *memmap = nullptr;
+  int state = 0;
+
+  static size_t calc_memmap_size(size_t size) {
+    const size_t npages = size >> PAGE_SHIFT;
+    const size_t memmap_size = npages << OOKPAGE_SIZE_SHIFT;
+    const size_t memmap_region_size =
+        (memmap_size + PAGE_SIZE - 1) & ~PAGE_MASK;
+
+    return memmap_region_size;
+  }
+
+  /**
+   * @warning size must be PAGE_SIZE aligned, and should be 2 pages or more.
+   */
+  int register_region(void *addr, size_t size) {
+    if (this->state & OOKREGION_STATE_REGISTERED)
+      return -EFAULT;
+
+    if (size & PAGE_MASK)
+      return -EINVAL;
+
+    const size_t memmap_size = calc_memmap_size(size);
+
+    if (memmap_size >= size)
+      return -ERANGE;
+
+    this->addr = addr;
+    this->size = size;
+    this->memmap = reinterpret_cast<struct ookpage *>(
+        reinterpret_cast<uintptr_t>(addr) + (size - memmap_size));
+    this->state |= OOKREGION_STATE_REGISTERED;
+
+    return 0;
+  }
+
+  bool registered() const {
+    return static_cast<bool>(this->state & OOKREGION_STATE_REGISTERED);
+  }
+
+  bool inrange(void *p) const { return inrange(p, 1); }
+
+  bool inrange(void *p, size_t size) const {
+    const auto [allocatable_addr, allocatable_size] = allocatable_region();
+    return (allocatable_addr <= p &&
+            reinterpret_cast<uintptr_t>(p) + size <=
+                reinterpret_cast<uintptr_t>(allocatable_addr) +
+                    allocatable_region().size);
+  }
+
+  struct mem_region_t {
+    void *addr;
+    size_t size;
+  };
+  struct mem_region_t allocatable_region() const {
+    return mem_region_t{
+        .addr = addr,
+        .size = static_cast<size_t>(reinterpret_cast<uintptr_t>(memmap) -
+                                    reinterpret_cast<uintptr_t>(addr))};
+  }
+
+  struct ookpage *get_memmap_entry(void *p) const {
+    if (!inrange(p))
+      return nullptr;
+
+    return &this->memmap[(reinterpret_cast<uintptr_t>(p) -
+                          reinterpret_cast<uintptr_t>(this->addr)) >>
+                         PAGE_SHIFT];
+  }
+};
+
+class PageAllocator {
+public:
+  int register_region(void *addr, size_t size) {
+    int ret;
+
+    for (unsigned int k = 0; k < std::size(registered_regions); ++k) {
+      OOKRegion *region = &registered_regions[k];
+      if (!region->registered()) {
+        OOKRegion new_region;
+        ret = new_region.register_region(addr, size);
+        if (ret)
+          return ret;
+
+        ret = insert_region(&new_region);
+        if (ret)
+          return ret;
+
+        *region = std::move(new_region);
+        return 0;
+      }
+    }
+
+    return -ENOMEM;
+  }
+
+  std::pair<int, struct ookpage *> allocate(size_t size) {
+    if (size == 0)
+      return {0, nullptr};
+
+    if (size & PAGE_MASK)
+      return {-EINVAL, nullptr};
+
+    if (size > (static_cast<size_t>(1) << (MAX_BLOCK_ORDER + PAGE_SHIFT)))
+      return {-ENOMEM, nullptr};
+
+    unsigned int order = log2ceil(size >> PAGE_SHIFT);
+
+    auto [ret, alloc_result] = allocate_pow2(order);
+
+    OOKBugOn(!ret &&
+             (alloc_result.region == nullptr || alloc_result.addr == nullptr));
+
+    if (ret)
+      return {ret, nullptr};
+
+    struct OOKRegion *region = alloc_result.region;
+    void *addr = alloc_result.addr;
+
+    size_t rem_size = (static_cast<size_t>(1) << (order + PAGE_SHIFT)) - size;
+
+    deallocate_impl(
+        mem_location_t{
+            .region = region,
+            .addr = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(addr) +
+                                             size),
+        },
+        rem_size);
+
+    struct ookpage *ookpage =
+        region->get_memmap_entry(reinterpret_cast<void *>(addr));
+
+    ookpage->addr = addr;
+    ookpage->size = size;
+
+    return {0, ookpage};
+  }
+
+  void deallocate(struct ookpage *ookpage) {
+    if (ookpage == nullptr)
+      return;
+
+    void *addr = ookpage->addr;
+    size_t size = ookpage->size;
+
+    OOKBugOn(size == 0);
+
+    ookpage->addr = nullptr;
+    ookpage->size = 0;
+
+    auto [ret, region_id] = find_region(addr);
+    OOKBugOn(ret);
+
+    struct OOKRegion *region = &registered_regions[region_id];
+
+    deallocate_impl(
+        mem_location_t{
+            .region = region,
+            .addr = addr,
+        },
+        size);
+  }
+
+  struct ookpage *page_to_desc(void *addr) {
+    if (addr == nullptr)
+      return nullptr;
+
+    auto [ret, region_id] = find_region(addr);
+    OOKBugOn(ret);
+
+    struct OOKRegion *region = &registered_regions[region_id];
+
+    struct ookpage *ookpage =
+        region->get_memmap_entry(reinterpret_cast<void *>(addr));
+
+    OOKBugOn(ookpage == nullptr);
+
+    return ookpage;
+  }
+
+private:
+  struct mem_location_t {
+    struct OOKRegion *region;
+    void *addr;
+  };
+
+  int insert_region(struct OOKRegion *region) {
+    OOKBugOn(region == nullptr);
+
+    if (!region->registered())
+      return -EFAULT;
+
+    const auto [addr, size] = region->allocatable_region();
+
+    return deallocate_impl(
+        mem_location_t{
+            .region = region,
+            .addr = addr,
+        },
+        size);
+  }
+
+  int deallocate_impl(struct mem_location_t mem, size_t size) {
+    OOKBugOn(mem.region == nullptr);
+    OOKBugOn(mem.addr == nullptr);
+
+    struct OOKRegion *region = mem.region;
+    void *addr = mem.addr;
+
+    const uintptr_t uaddr = reinterpret_cast<uintptr_t>(addr);
+    const uintptr_t uaddr_end = uaddr + size;
+
+    if (uaddr & PAGE_MASK)
+      return -EINVAL;
+    if (uaddr_end & PAGE_MASK)
+      return -EINVAL;
+
+    uintptr_t p;
+    for (p = uaddr; p < uaddr_end;) {
+      const unsigned int address_align_log2 = ctz(p);
+      OOKBugOn(address_align_log2 < PAGE_SHIFT);
+
+      const size_t remain_size = uaddr_end - p;
+      const unsigned int remainder_align_log2 = log2floor(remain_size);
+      OOKBugOn(remainder_align_log2 < PAGE_SHIFT);
+
+      const unsigned int block_size_log2 = std::min(
+          std::min(address_align_log2, remainder_align_log2) - PAGE_SHIFT,
+          MAX_BLOCK_ORDER);
+
+      OOKBugOn(!(block_size_log2 <= MAX_BLOCK_ORDER));
+
+      struct ookpage *block =
+          region->get_memmap_entry(reinterpret_cast<void *>(p));
+
+      block->addr = reinterpret_cast<void *>(p);
+      block->size = static_cast<size_t>(1) << (block_size_log2 + PAGE_SHIFT);
+      block->list.reset();
+
+      for (size_t i = 1; i < (1UL << block_size_log2); i++) {
+        struct ookpage *block_next = &block[i];
+        block_next->addr = nullptr;
+        block_next->size =
+            0; /* Only the leading page entry will hold the actual size. */
+        block_next->list.reset();
+      }
+
+      deallocate_pow2(
+          mem_location_t{
+              .region = region,
+              .addr = block->addr,
+          },
+          block_size_log2);
+
+      p += static_cast<uintptr_t>(1) << (block_size_log2 + PAGE_SHIFT);
+    }
+    OOKBugOn(p != uaddr_end);
+
+    return 0;
+  }
+
+  std::pair<int, unsigned int> find_region(void *addr) {
+    if (addr == nullptr)
+      return {-EINVAL, 0};
+
+    for (unsigned int k = 0; k < std::size(registered_regions); ++k) {
+      OOKRegion *region = &registered_regions[k];
+      if (region->registered() && region->inrange(addr)) {
+        return {0, k};
+      }
+    }
+
+    return {-ENOENT, 0};
+  }
+
+  std::pair<int, struct mem_location_t> allocate_pow2(unsigned int order) {
+    if (order > MAX_BLOCK_ORDER)
+      return {-ENOMEM, {}};
+
+    struct ookpage *ookpage = nullptr;
+    unsigned int found_order = 0;
+
+    for (unsigned int alloc_order = order; alloc_order <= MAX_BLOCK_ORDER;
+         alloc_order++) {
+      struct list_head *block = &blocks[alloc_order];
+      if (!block->empty()) {
+        struct list_head *alloc_chunk = block->next;
+        alloc_chunk->remove();
+
+        ookpage = container_of(alloc_chunk, struct ookpage, list);
+        ookpage->list.remove();
+        found_order = alloc_order;
+        goto found_chunk;
+      }
+    }
+
+    return {-ENOMEM, {}};
+
+  found_chunk:
+    void *addr = ookpage->addr;
+    uintptr_t uaddr = reinterpret_cast<uintptr_t>(addr);
+    unsigned int region_id;
+
+    if (auto [ret, region_id_] = find_region(addr); ret)
+      return {ret, {}};
+    else
+      region_id = region_id_;
+
+    struct OOKRegion *region = &registered_regions[region_id];
+
+    for (unsigned int i = found_order; i > order;) {
+      --i;
+
+      size_t half_size = 1UL << (i + PAGE_SHIFT);
+      uintptr_t pair_uaddr = uaddr ^ (1UL << (i + PAGE_SHIFT));
+      void *pair_addr = reinterpret_cast<void *>(pair_uaddr);
+      struct ookpage *pair_ookpage = region->get_memmap_entry(pair_addr);
+
+      pair_ookpage->addr = pair_addr;
+      pair_ookpage->size = half_size;
+      pair_ookpage->list.reset();
+
+      blocks[i].add(&pair_ookpage->list);
+    }
+
+    ookpage->addr = nullptr; /* Not owned regions will be zeroed out. */
+    ookpage->size = 0;
+    ookpage->list.reset();
+
+    return {0, mem_location_t{
+                   .region = region,
+                   .addr = addr,
+               }};
+  }
+
+  void deallocate_pow2(struct mem_location_t mem, unsigned int order) {
+    OOKBugOn(mem.region == nullptr);
+    OOKBugOn(mem.addr == nullptr);
+    OOKBugOn(order > MAX_BLOCK_ORDER);
+
+    struct OOKRegion *region = mem.region;
+
+    uintptr_t uaddr = reinterpret_cast<uintptr_t>(mem.addr);
+    size_t size = 1UL << (order + PAGE_SHIFT);
+
+    struct ookpage *ookpage = region->get_memmap_entry(mem.addr);
+
+    OOKBugOn(uaddr & (size - 1));
+
+    OOKBugOn(!ookpage->list.empty());
+    ookpage->addr = nullptr;
+    ookpage->size = 0;
+
+    while (order < MAX_BLOCK_ORDER) {
+      uintptr_t pair_uaddr = uaddr ^ size;
+
+      if (!region->inrange(reinterpret_cast<void *>(pair_uaddr), size))
+        break;
+
+      struct ookpage *pair_ookpage =
+          region->get_memmap_entry(reinterpret_cast<void *>(pair_uaddr));
+
+      OOKBugOn(pair_ookpage->size > (1UL << (order + PAGE_SHIFT)));
+
+      if (pair_ookpage->size != (1UL << (order + PAGE_SHIFT)))
+        break;
+
+      if (pair_ookpage->list.empty())
+        break;
+
+      pair_ookpage->list.remove();
+      pair_ookpage->addr = nullptr;
+      pair_ookpage->size = 0;
+
+      if (uaddr > pair_uaddr) {
+        std::swap(uaddr, pair_uaddr);
+        std::swap(ookpage, pair_ookpage);
+      }
+
+      order++;
+      size <<= 1;
+    }
+
+    ookpage->addr = reinterpret_cast<void *>(uaddr);
+    ookpage->size = size;
+    blocks[order].add(&ookpage->list);
+  }
+
+private:
+  /**
+   * Page allocation itself requires retrieving the region of memory,
+   * so it is crucial that the regions are owned by the page allocator.
+   */
+  OOKRegion registered_regions[MAX_NUM_REGIONS];
+
+  struct list_head blocks[1 + MAX_BLOCK_ORDER];
+};
+
+static PageAllocator page_allocator;
+
+/* Threads on any processor allocate stacks, so the allocator is shared. */
+static struct spinlock page_allocator_lock;
+
+} // namespace
+
+int register_region(void *addr, size_t size) {
+  unsigned long flags = spin_lock_irqsave(&page_allocator_lock);
+  int ret = page_allocator.register_region(addr, size);
+
+  spin_unlock_irqrestore(&page_allocator_lock, flags);
+  return ret;
+}
+
+void *__get_pages(size_t size) {
+  unsigned long flags = spin_lock_irqsave(&page_allocator_lock);
+  auto [ret, ookpage] = page_allocator.allocate(size);
+
+  spin_unlock_irqrestore(&page_allocator_lock, flags);
+  if (ret || ookpage == nullptr)
+    return nullptr;
+
+  return ookpage->addr;
+}
+
+void return_pages(void *p, size_t size) {
+  unsigned long flags = spin_lock_irqsave(&page_allocator_lock);
+  struct ookpage *ookpage = page_allocator.page_to_desc(p);
+
+  if (ookpage != nullptr) {
+    OOKBugOn(ookpage->addr != p || ookpage->size != size);
+    page_allocator.deallocate(ookpage);
+  }
+
+  spin_unlock_irqrestore(&page_allocator_lock, flags);
+}
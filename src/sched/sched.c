@@ -0,0 +1,507 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <apic/lapic.h>
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <display/display.h>
+#include <idt/irq.h>
+#include <idt/softirq.h>
+#include <memory/memory.h>
+#include <memory/page_alloc.h>
+#include <sched/steal_queue.h>
+#include <sched/preempt.h>
+#include <sched/sched.h>
+#include <smp/smp.h>
+#include <sync/spinlock.h>
+#include <time/ktime.h>
+#include <time/timer.h>
+
+enum thread_state {
+  THREAD_RUNNING,
+  THREAD_RUNNABLE,
+  THREAD_SLEEPING,
+  THREAD_DEAD,
+};
+
+/**
+ * Thread control block, at the bottom of the stack of the thread.
+ * Registers are saved on the stack by switch_to, so only the stack
+ * pointer is kept here.
+ */
+struct thread {
+  /* This should stay first, which <src/sched/switch.asm> relies on. */
+  uintptr_t sp;
+  struct thread *next;
+  thread_fn_t fn;
+  void *ctx;
+  enum thread_state state;
+  /* Set while a processor is on the stack, until it has switched away. */
+  bool on_cpu;
+  /* Processor the thread last ran on. */
+  unsigned int cpu;
+  /* preempt_count of the thread, while it is switched away. */
+  unsigned int preempt_count;
+  /* Wakes the thread up from thread_sleep_until. */
+  struct timer sleep_timer;
+};
+
+/**
+ * Stack left by switch_to, which should match <src/sched/switch.asm>.
+ * New threads start with one which returns to thread_entry.
+ */
+struct switch_frame {
+#ifdef CONFIG_X86_64
+  uint64_t r15;
+  uint64_t r14;
+  uint64_t r13;
+  uint64_t r12;
+  uint64_t rbp;
+  uint64_t rbx;
+#else
+  uint32_t ebp;
+  uint32_t edi;
+  uint32_t esi;
+  uint32_t ebx;
+#endif /* CONFIG_X86_64 */
+  uintptr_t ret;
+  /* Return address of thread_entry, which keeps the stack aligned. */
+  uintptr_t entry_ret;
+};
+
+void switch_to(struct thread *prev, struct thread *next);
+
+DEFINE_PER_CPU(unsigned int, preempt_count);
+
+DEFINE_PER_CPU(struct sched_stats, sched_stats);
+
+static DEFINE_PER_CPU(struct steal_queue, sched_runqueue);
+static DEFINE_PER_CPU(struct thread *, sched_current);
+static DEFINE_PER_CPU(struct thread, sched_idle_thread);
+static DEFINE_PER_CPU(bool, sched_need_resched);
+static DEFINE_PER_CPU(struct timer, sched_slice_timer);
+
+/* Thread switched away from, which the next thread finishes with. */
+static DEFINE_PER_CPU(struct thread *, sched_prev);
+static DEFINE_PER_CPU(bool, sched_prev_dead);
+
+/* Runnable threads which do not fit in the run queue of their processor. */
+static struct thread *sched_overflow_head;
+static struct thread *sched_overflow_tail;
+static struct spinlock sched_overflow_lock = SPINLOCK_INIT;
+
+/**
+ * Processors halted in sched_idle, which are woken up to steal threads.
+ * This holds a bit per processor, which CONFIG_MAX_CPUS fits in.
+ */
+static uint32_t sched_idle_cpus;
+_Static_assert(CONFIG_MAX_CPUS <= 32, "sched_idle_cpus holds a bit per CPU");
+
+/**
+ * @brief Put a runnable thread on the run queue of the calling processor,
+ * with interrupts disabled.
+ */
+static void sched_enqueue(struct thread *thread) {
+  if (steal_queue_push(this_cpu_ptr(sched_runqueue), thread) == 0)
+    return;
+
+  spin_lock(&sched_overflow_lock);
+  thread->next = NULL;
+  if (sched_overflow_tail != NULL)
+    sched_overflow_tail->next = thread;
+  else
+    sched_overflow_head = thread;
+  sched_overflow_tail = thread;
+  spin_unlock(&sched_overflow_lock);
+}
+
+static struct thread *sched_dequeue_overflow() {
+  struct thread *thread;
+
+  if (__atomic_load_n(&sched_overflow_head, __ATOMIC_RELAXED) == NULL)
+    return NULL;
+
+  spin_lock(&sched_overflow_lock);
+  thread = sched_overflow_head;
+  if (thread != NULL) {
+    sched_overflow_head = thread->next;
+    if (sched_overflow_head == NULL)
+      sched_overflow_tail = NULL;
+  }
+  spin_unlock(&sched_overflow_lock);
+  return thread;
+}
+
+/**
+ * @brief Steal half of the run queue of the next processor which has
+ * runnable threads, and return the first of them to run.
+ */
+static struct thread *sched_steal() {
+  const unsigned int self = smp_processor_id();
+  const unsigned int ncpu = smp_cpu_count();
+  struct sched_stats *stats = this_cpu_ptr(sched_stats);
+
+  for (unsigned int i = 1; i < ncpu; ++i) {
+    struct steal_queue *runqueue =
+        per_cpu_ptr(sched_runqueue, (self + i) % ncpu);
+    unsigned long count = (steal_queue_size(runqueue) + 1) / 2;
+    struct thread *first = NULL;
+
+    for (; count > 0; --count) {
+      struct thread *thread = steal_queue_pop(runqueue);
+
+      if (thread == NULL)
+        break;
+      if (first == NULL)
+        first = thread;
+      else
+        sched_enqueue(thread);
+      stats->stolen++;
+    }
+
+    if (first != NULL) {
+      stats->steals++;
+      return first;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Next thread to run on the calling processor, with interrupts
+ * disabled: the oldest one queued here, then one which did not fit
+ * in any run queue, then one stolen from another processor.
+ */
+static struct thread *sched_dequeue() {
+  struct steal_queue *runqueue = this_cpu_ptr(sched_runqueue);
+  struct thread *thread;
+
+  /* Owner pops the oldest thread like thieves do, racing with them. */
+  while (steal_queue_size(runqueue) != 0) {
+    thread = steal_queue_pop(runqueue);
+    if (thread != NULL)
+      return thread;
+  }
+
+  thread = sched_dequeue_overflow();
+  if (thread != NULL)
+    return thread;
+
+  return sched_steal();
+}
+
+/**
+ * @brief Whether sched_dequeue may find a thread.
+ */
+static bool sched_work_available() {
+  const unsigned int ncpu = smp_cpu_count();
+
+  if (__atomic_load_n(&sched_overflow_head, __ATOMIC_RELAXED) != NULL)
+    return true;
+
+  for (unsigned int cpu = 0; cpu < ncpu; ++cpu) {
+    if (steal_queue_size(per_cpu_ptr(sched_runqueue, cpu)) != 0)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Wake up a processor halted in sched_idle, so that it steals
+ * threads waiting here.
+ */
+static void sched_wake_idle_cpu() {
+  const uint32_t self = 1U << smp_processor_id();
+  unsigned int cpu;
+  uint32_t idle;
+
+  /* Pairs with sched_idle, which marks itself before looking for work. */
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  idle = __atomic_load_n(&sched_idle_cpus, __ATOMIC_RELAXED) & ~self;
+  if (idle == 0)
+    return;
+
+  /* Only the one which clears the mark sends the IPI. */
+  cpu = (unsigned int)__builtin_ctz(idle);
+  if (__atomic_fetch_and(&sched_idle_cpus, ~(1U << cpu), __ATOMIC_SEQ_CST) &
+      (1U << cpu)) {
+    lapic_send_fixed(smp_cpu_apic_id(cpu), SCHED_IPI_VECTOR);
+    this_cpu_ptr(sched_stats)->ipis++;
+  }
+}
+
+static void irq_handler_sched_ipi(struct trap_frame *frame, void *ctx) {
+  lapic_eoi();
+  this_cpu_write(sched_need_resched, true);
+}
+
+static void sched_slice_expired(void *ctx) {
+  this_cpu_write(sched_need_resched, true);
+}
+
+/**
+ * @brief Find a processor for a thread just queued here, with interrupts
+ * disabled. The idle thread gives way to one thread on the next interrupt,
+ * and an idle processor is woken up to steal any other. The running
+ * thread of a busy processor gives way when its slice ends.
+ */
+static void sched_kick() {
+  struct timer *slice = this_cpu_ptr(sched_slice_timer);
+
+  if (this_cpu_read(sched_current) == this_cpu_ptr(sched_idle_thread)) {
+    this_cpu_write(sched_need_resched, true);
+    if (steal_queue_size(this_cpu_ptr(sched_runqueue)) > 1)
+      sched_wake_idle_cpu();
+    return;
+  }
+
+  sched_wake_idle_cpu();
+  if (!timer_pending(slice))
+    timer_add(slice, ktime_get_ns() + SCHED_SLICE_NS, sched_slice_expired,
+              NULL);
+}
+
+/**
+ * @brief Finish switching on the thread switched to,
+ * with interrupts disabled.
+ */
+static void sched_finish_switch() {
+  struct thread *prev = this_cpu_read(sched_prev);
+  struct thread *current = this_cpu_read(sched_current);
+  struct timer *slice = this_cpu_ptr(sched_slice_timer);
+
+  /* Threads which gave way with preemption disabled keep it disabled. */
+  this_cpu_write(preempt_count, current->preempt_count);
+
+  /* Stack is no longer in use, now that the processor is off it. */
+  if (this_cpu_read(sched_prev_dead))
+    return_pages(prev, THREAD_STACK_SIZE);
+  else
+    __atomic_store_n(&prev->on_cpu, false, __ATOMIC_RELEASE);
+
+  /* Idle thread is preempted without a slice. */
+  if (current == this_cpu_ptr(sched_idle_thread))
+    timer_cancel(slice);
+  else
+    timer_add(slice, ktime_get_ns() + SCHED_SLICE_NS, sched_slice_expired,
+              NULL);
+}
+
+/**
+ * @brief Switch to the first runnable thread, putting the running one
+ * at the back if it is still running.
+ *
+ * The running thread keeps going if no other thread is runnable,
+ * and the idle thread runs if none is.
+ */
+static void schedule() {
+  const unsigned long flags = x86_irq_save();
+  struct thread *prev = this_cpu_read(sched_current);
+  struct thread *idle = this_cpu_ptr(sched_idle_thread);
+  const enum thread_state state =
+      __atomic_load_n(&prev->state, __ATOMIC_ACQUIRE);
+  const unsigned int cpu = smp_processor_id();
+  struct sched_stats *stats = this_cpu_ptr(sched_stats);
+  struct thread *next;
+
+  this_cpu_write(sched_need_resched, false);
+
+  /* Sleeping threads are queued by whoever wakes them up. */
+  if (state == THREAD_RUNNING && prev != idle) {
+    __atomic_store_n(&prev->state, THREAD_RUNNABLE, __ATOMIC_RELAXED);
+    sched_enqueue(prev);
+  }
+  next = sched_dequeue();
+  if (next == NULL)
+    next = idle;
+
+  /* Threads left waiting here, including prev, may run elsewhere. */
+  if (steal_queue_size(this_cpu_ptr(sched_runqueue)) != 0)
+    sched_wake_idle_cpu();
+  __atomic_store_n(&next->state, THREAD_RUNNING, __ATOMIC_RELAXED);
+
+  if (next == prev) {
+    x86_irq_restore(flags);
+    return;
+  }
+
+  /* Thread may still be switching away on another processor. */
+  while (__atomic_load_n(&next->on_cpu, __ATOMIC_ACQUIRE))
+    x86_pause();
+  next->on_cpu = true;
+
+  stats->switches++;
+  if (next->cpu != cpu) {
+    stats->migrations++;
+    next->cpu = cpu;
+  }
+
+  this_cpu_write(sched_current, next);
+  this_cpu_write(sched_prev, prev);
+  this_cpu_write(sched_prev_dead, state == THREAD_DEAD);
+  prev->preempt_count = this_cpu_read(preempt_count);
+  switch_to(prev, next);
+
+  /* This is now the thread switched back to, with its own flags. */
+  sched_finish_switch();
+  x86_irq_restore(flags);
+}
+
+/**
+ * @brief First code of each thread, which switch_to returns to.
+ */
+static void thread_entry() {
+  struct thread *current;
+
+  sched_finish_switch();
+  x86_irq_enable();
+
+  current = this_cpu_read(sched_current);
+  current->fn(current->ctx);
+  thread_exit();
+}
+
+void sched_init() {
+  struct thread *idle = this_cpu_ptr(sched_idle_thread);
+
+  /* The flow of control so far is the idle thread, on its own stack. */
+  idle->state = THREAD_RUNNING;
+  idle->on_cpu = true;
+  idle->cpu = smp_processor_id();
+  this_cpu_write(sched_current, idle);
+
+  irq_register(SCHED_IPI_VECTOR, irq_handler_sched_ipi, NULL);
+}
+
+void sched_idle() {
+  const uint32_t self = 1U << smp_processor_id();
+
+  while (1) {
+    x86_irq_disable();
+    schedule();
+
+    /**
+     * Marked before looking for work, so that a processor queueing
+     * a thread meanwhile either sees the mark or the thread is seen here.
+     */
+    __atomic_fetch_or(&sched_idle_cpus, self, __ATOMIC_SEQ_CST);
+    if (!sched_work_available() && this_cpu_read(softirq_pending) == 0)
+      x86_safe_halt();
+    __atomic_fetch_and(&sched_idle_cpus, ~self, __ATOMIC_SEQ_CST);
+
+    /* Softirqs left pending outside of interrupts run here. */
+    x86_irq_enable();
+    softirq_run_pending();
+  }
+}
+
+void sched_irq_exit(const struct trap_frame *frame) {
+  if (!(trap_frame_flags(frame) & X86_EFLAGS_IF) ||
+      this_cpu_read(preempt_count) != 0 ||
+      !this_cpu_read(sched_need_resched) ||
+      this_cpu_read(sched_current) == NULL)
+    return;
+
+  schedule();
+}
+
+struct thread *thread_create(thread_fn_t fn, void *ctx) {
+  struct thread *thread = get_pages(THREAD_STACK_SIZE);
+  struct switch_frame *frame;
+  unsigned long flags;
+
+  if (thread == NULL)
+    return NULL;
+
+  kmemset(thread, 0, sizeof(*thread));
+  thread->fn = fn;
+  thread->ctx = ctx;
+
+  frame =
+      (struct switch_frame *)((uintptr_t)thread + THREAD_STACK_SIZE) - 1;
+  kmemset(frame, 0, sizeof(*frame));
+  frame->ret = (uintptr_t)thread_entry;
+  thread->sp = (uintptr_t)frame;
+  thread->state = THREAD_RUNNABLE;
+
+  flags = x86_irq_save();
+  thread->cpu = smp_processor_id();
+  sched_enqueue(thread);
+  sched_kick();
+  x86_irq_restore(flags);
+
+  return thread;
+}
+
+struct thread *thread_current() { return this_cpu_read(sched_current); }
+
+void thread_yield() { schedule(); }
+
+static void thread_sleep_expired(void *ctx) { thread_wake(ctx); }
+
+void thread_sleep_until(uint64_t deadline_ns) {
+  const unsigned long flags = x86_irq_save();
+  struct thread *current = this_cpu_read(sched_current);
+
+  __atomic_store_n(&current->state, THREAD_SLEEPING, __ATOMIC_RELEASE);
+
+  /* Timer runs on this processor, which is not before the switch. */
+  timer_add(&current->sleep_timer, deadline_ns, thread_sleep_expired,
+            current);
+  schedule();
+  x86_irq_restore(flags);
+
+  /**
+   * Thread may be woken up by thread_wake before the deadline, while the
+   * timer fires on another processor. Its callback is waited for, so that
+   * it never wakes the thread from a later sleep or after it exits.
+   */
+  timer_cancel_sync(&current->sleep_timer);
+}
+
+void thread_wake(struct thread *thread) {
+  enum thread_state state = THREAD_SLEEPING;
+  unsigned long flags;
+
+  /* Only one waker gets to queue the thread. */
+  if (!__atomic_compare_exchange_n(&thread->state, &state, THREAD_RUNNABLE,
+                                   false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    return;
+
+  /* Thread lands on the run queue of the waker. */
+  flags = x86_irq_save();
+  sched_enqueue(thread);
+  sched_kick();
+  x86_irq_restore(flags);
+}
+
+void thread_exit() {
+  x86_irq_disable();
+  __atomic_store_n(&this_cpu_read(sched_current)->state, THREAD_DEAD,
+                   __ATOMIC_RELAXED);
+  schedule();
+
+  /* Dead thread is never switched back to. */
+  while (1) {
+    x86_halt();
+  }
+}
+
+void sched_get_stats(unsigned int cpu, struct sched_stats *stats) {
+  *stats = *per_cpu_ptr(sched_stats, cpu);
+}
+
+void sched_stats_dump() {
+  for (unsigned int cpu = 0; cpu < smp_cpu_count(); ++cpu) {
+    struct sched_stats stats;
+
+    sched_get_stats(cpu, &stats);
+    terminal_printk("CPU %u: %u switches, %u migrations, "
+                    "%u steals of %u threads, %u IPIs\n",
+                    cpu, (unsigned int)stats.switches,
+                    (unsigned int)stats.migrations, (unsigned int)stats.steals,
+                    (unsigned int)stats.stolen, (unsigned int)stats.ipis);
+  }
+}
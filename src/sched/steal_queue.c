@@ -0,0 +1,49 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <sched/steal_queue.h>
+
+static inline void **steal_queue_slot(struct steal_queue *queue,
+                                      unsigned long index) {
+  return &queue->items[index & (STEAL_QUEUE_SIZE - 1)];
+}
+
+int steal_queue_push(struct steal_queue *queue, void *item) {
+  const unsigned long tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+  /* Slots are not reused before the consumers are done reading them. */
+  const unsigned long head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+  if (tail - head >= STEAL_QUEUE_SIZE)
+    return -1;
+
+  __atomic_store_n(steal_queue_slot(queue, tail), item, __ATOMIC_RELAXED);
+  /* Item is visible to consumers before the new tail. */
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+void *steal_queue_pop(struct steal_queue *queue) {
+  unsigned long head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  const unsigned long tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+  void *item;
+
+  if ((long)(tail - head) <= 0)
+    return NULL;
+
+  /**
+   * Slot is read before the claim, and the owner only writes it again
+   * once the head has moved past it, which then fails the claim.
+   */
+  item = __atomic_load_n(steal_queue_slot(queue, head), __ATOMIC_RELAXED);
+  if (!__atomic_compare_exchange_n(&queue->head, &head, head + 1, false,
+                                   __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    return NULL;
+  return item;
+}
+
+unsigned long steal_queue_size(const struct steal_queue *queue) {
+  const unsigned long head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+  const unsigned long tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+
+  return (long)(tail - head) > 0 ? tail - head : 0;
+}
@@ -0,0 +1,45 @@
+GLOBAL switch_to
+
+SECTION .text
+
+; void switch_to(struct thread *prev, struct thread *next)
+;
+; Callee saved registers of prev are pushed on its stack, and the stack
+; pointer is saved in the first field of prev. The stack of next is
+; then restored the same way, so switch_to returns in next where it was
+; switched away from. This should match struct switch_frame
+; and struct thread in <src/sched/sched.c>.
+%ifdef CONFIG_X86_64
+switch_to:
+  push rbx
+  push rbp
+  push r12
+  push r13
+  push r14
+  push r15
+  mov [rdi], rsp
+  mov rsp, [rsi]
+  pop r15
+  pop r14
+  pop r13
+  pop r12
+  pop rbp
+  pop rbx
+  ret
+%else
+switch_to:
+  push ebx
+  push esi
+  push edi
+  push ebp
+  ; Arguments are above the return address and the four registers.
+  mov eax, [esp + 20]
+  mov edx, [esp + 24]
+  mov [eax], esp
+  mov esp, [edx]
+  pop ebp
+  pop edi
+  pop esi
+  pop ebx
+  ret
+%endif
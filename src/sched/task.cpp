@@ -0,0 +1,147 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <idt/softirq.h>
+#include <sched/task.h>
+
+namespace {
+
+/**
+ * State of a future is its continuation, if any, with the completing bit
+ * set once a completer claims it, and the done state once the result
+ * is written. Tasks are aligned, so neither bit is part of a task.
+ */
+constexpr uintptr_t FUTURE_STATE_DONE = 1;
+constexpr uintptr_t FUTURE_STATE_COMPLETING = 2;
+constexpr uintptr_t FUTURE_STATE_FLAGS =
+    FUTURE_STATE_DONE | FUTURE_STATE_COMPLETING;
+
+static_assert(alignof(struct task) > FUTURE_STATE_FLAGS);
+
+/**
+ * Tasks queued on a processor in FIFO order. This is only touched
+ * by its own processor, with interrupts disabled.
+ */
+struct ready_queue {
+  struct task *head;
+  struct task *tail;
+
+  void push(struct task *task) {
+    task->next = nullptr;
+    if (tail != nullptr)
+      tail->next = task;
+    else
+      head = task;
+    tail = task;
+  }
+
+  /**
+   * @brief Take the whole queue, so that tasks queued while it runs
+   * wait for the next round.
+   */
+  struct task *take_all() {
+    struct task *list = head;
+
+    head = tail = nullptr;
+    return list;
+  }
+};
+
+DEFINE_PER_CPU(struct ready_queue, task_ready_queue);
+
+void task_run_ready() {
+  struct task *list;
+
+  x86_irq_disable();
+  list = this_cpu_ptr(task_ready_queue)->take_all();
+  x86_irq_enable();
+
+  while (list != nullptr) {
+    struct task *task = list;
+
+    list = task->next;
+    __atomic_store_n(&task->queued, false, __ATOMIC_RELEASE);
+    task->fn(task);
+  }
+}
+
+} // namespace
+
+void executor_init() { softirq_register(SOFTIRQ_TASK, task_run_ready); }
+
+void task_init(struct task *task, task_fn_t fn) {
+  task->next = nullptr;
+  task->fn = fn;
+  task->queued = false;
+}
+
+bool task_schedule(struct task *task) {
+  unsigned long flags;
+
+  if (__atomic_exchange_n(&task->queued, true, __ATOMIC_ACQUIRE))
+    return false;
+
+  flags = x86_irq_save();
+  this_cpu_ptr(task_ready_queue)->push(task);
+  softirq_raise(SOFTIRQ_TASK);
+  x86_irq_restore(flags);
+
+  /* Threads run the task right away, rather than on the next interrupt. */
+  softirq_run_pending();
+  return true;
+}
+
+void future_init(struct future *future) {
+  future->result = 0;
+  __atomic_store_n(&future->state, 0, __ATOMIC_RELAXED);
+}
+
+void future_then(struct future *future, struct task *task) {
+  uintptr_t state = __atomic_load_n(&future->state, __ATOMIC_ACQUIRE);
+
+  /**
+   * Completion either sees the task, or is seen here as done. A future
+   * being completed keeps its completing bit, and gets the task too.
+   */
+  do {
+    if (state == FUTURE_STATE_DONE) {
+      task_schedule(task);
+      return;
+    }
+  } while (!__atomic_compare_exchange_n(
+      &future->state, &state,
+      reinterpret_cast<uintptr_t>(task) | (state & FUTURE_STATE_COMPLETING),
+      false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+int future_complete(struct future *future, int result) {
+  uintptr_t state = __atomic_load_n(&future->state, __ATOMIC_RELAXED);
+
+  /* Only the completer which claims the future writes the result. */
+  do {
+    if (state & FUTURE_STATE_FLAGS)
+      return -1;
+  } while (!__atomic_compare_exchange_n(&future->state, &state,
+                                        state | FUTURE_STATE_COMPLETING, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+  /* Result is visible to whoever sees the future done. */
+  future->result = result;
+  state = __atomic_exchange_n(&future->state, FUTURE_STATE_DONE,
+                              __ATOMIC_ACQ_REL);
+
+  state &= ~FUTURE_STATE_FLAGS;
+  if (state != 0)
+    task_schedule(reinterpret_cast<struct task *>(state));
+  return 0;
+}
+
+bool future_done(const struct future *future) {
+  return __atomic_load_n(&future->state, __ATOMIC_ACQUIRE) ==
+         FUTURE_STATE_DONE;
+}
+
+int future_result(const struct future *future) { return future->result; }
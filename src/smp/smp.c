@@ -0,0 +1,167 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <acpi/madt.h>
+#include <apic/lapic.h>
+#include <config.h>
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <display/display.h>
+#include <idt/idt.h>
+#include <kernel.h>
+#include <memory/memory.h>
+#include <memory/page_alloc.h>
+#include <sched/sched.h>
+#include <smp/smp.h>
+#include <time/clockevent.h>
+#include <time/pit.h>
+
+/**
+ * These are symbols in <src/smp/trampoline.asm>,
+ * where only the address matters.
+ */
+extern char smp_trampoline_start[];
+extern char smp_trampoline_end[];
+
+#define SMP_STARTUP_VECTOR (SMP_TRAMPOLINE_ADDR >> PAGE_SHIFT)
+
+/* Delays between the IPIs, as suggested by the MultiProcessor Specification. */
+#define SMP_INIT_DELAY_US 10000
+#define SMP_STARTUP_DELAY_US 200
+
+/* Time to wait for a started processor to reach smp_ap_main. */
+#define SMP_ONLINE_TIMEOUT_MS 100
+
+struct smp_cpu {
+  uint32_t apic_id;
+  bool online;
+  /* Bottom of the stack, or NULL for the bootstrap processor. */
+  void *stack;
+};
+
+static struct smp_cpu smp_cpus[CONFIG_MAX_CPUS];
+static unsigned int smp_ncpu = 1;
+
+/**
+ * These are read by kernel_start_ap in <src/kernel.asm>.
+ * Processors are started one at a time, so they are shared by all of them.
+ */
+uintptr_t smp_ap_boot_stack;
+uint32_t smp_ap_boot_cpu;
+
+static inline bool smp_cpu_online(unsigned int cpu) {
+  return __atomic_load_n(&smp_cpus[cpu].online, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Entry of application processors from <src/kernel.asm>.
+ */
+void smp_ap_main(unsigned int cpu) {
+  percpu_init_ap(cpu);
+  idt_load();
+  lapic_enable();
+  clockevent_init_ap();
+  if (clockevent_per_cpu())
+    sched_init();
+
+  __atomic_store_n(&smp_cpus[cpu].online, true, __ATOMIC_RELEASE);
+
+  /* Timers would never fire here, so the scheduler is not joined. */
+  if (!clockevent_per_cpu()) {
+    terminal_printk("CPU %u has no timer events, and stays halted.\n", cpu);
+    while (1) {
+      x86_halt();
+    }
+  }
+
+  kernel_main_ap(cpu);
+}
+
+static int smp_start_cpu(unsigned int cpu) {
+  struct smp_cpu *target = &smp_cpus[cpu];
+
+  target->stack = get_pages(SMP_AP_STACK_SIZE);
+  if (target->stack == NULL)
+    return -1;
+
+  if (percpu_alloc(cpu)) {
+    return_pages(target->stack, SMP_AP_STACK_SIZE);
+    target->stack = NULL;
+    return -1;
+  }
+
+  smp_ap_boot_stack = (uintptr_t)target->stack + SMP_AP_STACK_SIZE;
+  smp_ap_boot_cpu = cpu;
+
+  lapic_send_init(target->apic_id);
+  pit_delay_us(SMP_INIT_DELAY_US);
+
+  /* Second one is for processors which miss the first one. */
+  for (int i = 0; i < 2 && !smp_cpu_online(cpu); ++i) {
+    lapic_send_startup(target->apic_id, SMP_STARTUP_VECTOR);
+    pit_delay_us(SMP_STARTUP_DELAY_US);
+  }
+
+  for (int i = 0; i < SMP_ONLINE_TIMEOUT_MS && !smp_cpu_online(cpu); ++i)
+    pit_delay_us(1000);
+
+  if (!smp_cpu_online(cpu)) {
+    /* Make sure it does not run on the stack after it is returned. */
+    lapic_send_init(target->apic_id);
+    return_pages(target->stack, SMP_AP_STACK_SIZE);
+    target->stack = NULL;
+    percpu_free(cpu);
+    return -1;
+  }
+
+  return 0;
+}
+
+unsigned int smp_init() {
+  const struct madt_info *madt = madt_get();
+  uint32_t bsp_apic_id;
+
+  if (madt == NULL || lapic_init()) {
+    terminal_print("SMP: local APIC is not available. "
+                   "Running on the bootstrap processor only.\n");
+    return smp_ncpu;
+  }
+
+  bsp_apic_id = lapic_id();
+  smp_cpus[0].apic_id = bsp_apic_id;
+  smp_cpus[0].online = true;
+
+  kmemcpy((void *)SMP_TRAMPOLINE_ADDR, smp_trampoline_start,
+          smp_trampoline_end - smp_trampoline_start);
+
+  for (uint32_t i = 0; i < madt->cpu_count; ++i) {
+    const uint32_t apic_id = madt->cpu_apic_ids[i];
+
+    if (apic_id == bsp_apic_id)
+      continue;
+    if (smp_ncpu == CONFIG_MAX_CPUS)
+      break;
+
+    smp_cpus[smp_ncpu].apic_id = apic_id;
+    if (smp_start_cpu(smp_ncpu)) {
+      terminal_printk("SMP: processor with APIC id %u did not start.\n",
+                      (unsigned int)apic_id);
+      continue;
+    }
+
+    /* Processors counted here have their per-CPU data set up. */
+    __atomic_store_n(&smp_ncpu, smp_ncpu + 1, __ATOMIC_RELEASE);
+  }
+
+  terminal_printk("SMP: %u of %u processors online\n", smp_ncpu,
+                  (unsigned int)madt->cpu_count);
+
+  return smp_ncpu;
+}
+
+unsigned int smp_cpu_count() {
+  return __atomic_load_n(&smp_ncpu, __ATOMIC_ACQUIRE);
+}
+
+uint32_t smp_cpu_apic_id(unsigned int cpu) { return smp_cpus[cpu].apic_id; }
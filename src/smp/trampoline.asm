@@ -0,0 +1,133 @@
+%ifdef CONFIG_X86_64
+EXTERN kernel_pml4
+%else
+EXTERN kernel_page_directory
+%endif
+EXTERN kernel_start_ap
+
+GLOBAL smp_trampoline_start
+GLOBAL smp_trampoline_end
+
+; This should match <include/smp/smp.h>.
+%define SMP_TRAMPOLINE_ADDR 0x8000
+
+; This should match <include/config.h>.
+%define KERNEL_CODE_SELECTOR 0x08
+%define KERNEL_DATA_SELECTOR 0x10
+
+; Long mode code segment, which is only in the GDT of the trampoline.
+%define SMP_TRAMPOLINE_CODE64_SELECTOR 0x18
+
+; This should match <include/memory/paging.h>.
+%ifdef CONFIG_X86_64
+%define KERNEL_VIRTUAL_BASE 0xFFFFFFFFC0000000
+%else
+%define KERNEL_VIRTUAL_BASE 0xC0000000
+%endif
+
+%define X86_CR0_PE (1 << 0)
+%define X86_CR0_WP (1 << 16)
+%define X86_CR0_PG (1 << 31)
+%define X86_CR4_PSE (1 << 4)
+%define X86_CR4_PAE (1 << 5)
+%define X86_CR4_PGE (1 << 7)
+
+%define X86_MSR_EFER 0xC0000080
+%define X86_EFER_LME (1 << 8)
+
+; Address of a label once the trampoline is copied to SMP_TRAMPOLINE_ADDR.
+%define TRAMPOLINE_ADDR(label) (SMP_TRAMPOLINE_ADDR + (label) - smp_trampoline_start)
+
+; This is only copied by <src/smp/smp.c>, and never runs in place.
+SECTION .rodata
+
+; Application processors start here in real mode, with cs:ip at 0x0800:0000.
+BITS 16
+align 16
+smp_trampoline_start:
+  cli
+  cld
+
+  xor ax, ax
+  mov ds, ax
+
+  lgdt [TRAMPOLINE_ADDR(smp_trampoline_gdt_descriptor)]
+
+  mov eax, cr0
+  or eax, X86_CR0_PE
+  mov cr0, eax
+
+  jmp dword KERNEL_CODE_SELECTOR:TRAMPOLINE_ADDR(smp_trampoline_protected_mode)
+
+BITS 32
+smp_trampoline_protected_mode:
+  mov ax, KERNEL_DATA_SELECTOR
+  mov ds, ax
+  mov es, ax
+  mov ss, ax
+
+  ; Paging is enabled the same way as the bootstrap processor in <src/kernel.asm>.
+%ifdef CONFIG_X86_64
+  mov eax, cr4
+  or eax, X86_CR4_PAE | X86_CR4_PGE
+  mov cr4, eax
+
+  mov eax, kernel_pml4 - KERNEL_VIRTUAL_BASE
+  mov cr3, eax
+
+  mov ecx, X86_MSR_EFER
+  rdmsr
+  or eax, X86_EFER_LME
+  wrmsr
+
+  mov eax, cr0
+  or eax, X86_CR0_PG | X86_CR0_WP
+  mov cr0, eax
+
+  jmp SMP_TRAMPOLINE_CODE64_SELECTOR:TRAMPOLINE_ADDR(smp_trampoline_long_mode)
+
+BITS 64
+smp_trampoline_long_mode:
+  ; Jump is absolute, so it lands in the higher half.
+  mov rax, kernel_start_ap
+  jmp rax
+%else
+  mov eax, cr4
+  or eax, X86_CR4_PSE | X86_CR4_PGE
+  mov cr4, eax
+
+  mov eax, kernel_page_directory - KERNEL_VIRTUAL_BASE
+  mov cr3, eax
+
+  mov eax, cr0
+  or eax, X86_CR0_PG | X86_CR0_WP
+  mov cr0, eax
+
+  ; Jump is absolute, so it lands in the higher half.
+  mov eax, kernel_start_ap
+  jmp eax
+%endif
+
+; GDT of the kernel is linked to the higher half, so a copy is used until paging is enabled.
+align 8
+smp_trampoline_gdt_start:
+  dd 0x00000000
+  dd 0x00000000
+
+  dw 0xffff, 0x0000
+  db 0x00, 0x9b, 0xcf, 0x00
+
+  dw 0xffff, 0x0000
+  db 0x00, 0x93, 0xcf, 0x00
+
+%ifdef CONFIG_X86_64
+  dw 0xffff, 0x0000
+  db 0x00, 0x9b, 0xaf, 0x00
+%endif
+smp_trampoline_gdt_end:
+
+smp_trampoline_gdt_descriptor:
+  dw smp_trampoline_gdt_end - smp_trampoline_gdt_start - 1
+  dd TRAMPOLINE_ADDR(smp_trampoline_gdt_start)
+
+smp_trampoline_end:
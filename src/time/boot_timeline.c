@@ -0,0 +1,82 @@
+#include <stdint.h>
+
+#include <boot/bootinfo.h>
+#include <cpu/cpu.h>
+#include <display/display.h>
+#include <math64.h>
+#include <time/boot_timeline.h>
+#include <time/ktime.h>
+
+/* This is stamped by <src/kernel.asm> on entry. */
+extern uint64_t kernel_start_tsc;
+
+static const char *const boot_phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_BOOT_SECTOR] = "boot sector",
+    [BOOT_PHASE_STAGE2] = "stage 2",
+    [BOOT_PHASE_KERNEL_READ] = "kernel read",
+    [BOOT_PHASE_KERNEL_LOADED] = "kernel loaded",
+    [BOOT_PHASE_KERNEL_START] = "kernel start",
+    [BOOT_PHASE_TERMINAL_INIT] = "terminal_init",
+    [BOOT_PHASE_MEMMAP_INIT] = "memmap_init",
+    [BOOT_PHASE_KTIME_INIT] = "ktime_init",
+    [BOOT_PHASE_IDT_INIT] = "idt_init",
+    [BOOT_PHASE_SMP_INIT] = "smp_init",
+};
+
+/* Time stamp counter at each checkpoint, or 0 if not reached. */
+static uint64_t boot_timeline[BOOT_PHASE_COUNT];
+
+void boot_timeline_init() {
+  const struct boot_info *info = kernel_boot_info();
+
+  if (boot_info_valid(info)) {
+    for (int i = 0; i < BOOT_PHASE_LOADER_COUNT; ++i)
+      boot_timeline[i] = info->timeline[i];
+  }
+
+  boot_timeline[BOOT_PHASE_KERNEL_START] = kernel_start_tsc;
+}
+
+void boot_timeline_stamp(enum boot_phase phase) {
+  boot_timeline[phase] = x86_rdtsc();
+}
+
+/**
+ * @brief Print a duration in cycles, and in microseconds
+ * once the time stamp counter is calibrated.
+ */
+static void boot_timeline_print_cycles(const char *name, uint64_t cycles) {
+  if (ktime_tsc_khz() == 0) {
+    terminal_printk("  %s: +%llu cycles\n", name, (unsigned long long)cycles);
+    return;
+  }
+
+  terminal_printk(
+      "  %s: +%llu us (%llu cycles)\n", name,
+      (unsigned long long)div_u64_u32(ktime_cycles_to_ns(cycles),
+                                      NSEC_PER_USEC),
+      (unsigned long long)cycles);
+}
+
+void boot_timeline_print() {
+  uint64_t first = 0, prev = 0;
+
+  terminal_print("Boot timeline:\n");
+
+  for (int i = 0; i < BOOT_PHASE_COUNT; ++i) {
+    const uint64_t stamp = boot_timeline[i];
+
+    if (stamp == 0)
+      continue;
+
+    if (first == 0) {
+      first = stamp;
+      prev = stamp;
+    }
+
+    boot_timeline_print_cycles(boot_phase_names[i], stamp - prev);
+    prev = stamp;
+  }
+
+  boot_timeline_print_cycles("total", prev - first);
+}
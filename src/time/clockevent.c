@@ -0,0 +1,276 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <apic/lapic.h>
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <display/display.h>
+#include <idt/idt.h>
+#include <idt/irq.h>
+#include <idt/softirq.h>
+#include <math64.h>
+#include <time/clockevent.h>
+#include <time/ktime.h>
+#include <time/pit.h>
+
+/* Local APIC timer is counted against ktime this long for its rate. */
+#define CLOCKEVENT_LAPIC_CALIBRATE_NS (10U * NSEC_PER_MSEC)
+
+/**
+ * Events further than this are reached in steps,
+ * which keeps the conversion to timer ticks within 64 bits.
+ */
+#define CLOCKEVENT_MAX_DELTA_NS ((uint64_t)NSEC_PER_SEC)
+
+/* Counter of PIT channel 0 is 16 bit wide. */
+#define CLOCKEVENT_PIT_MAX_DELTA_NS                                            \
+  ((uint64_t)UINT16_MAX * NSEC_PER_SEC / PIT_FREQUENCY_HZ)
+
+struct clockevent_device {
+  const char *name;
+  uint64_t max_delta_ns;
+  /* Set up the timer of the calling processor, or NULL for a shared timer. */
+  void (*init_cpu)();
+  /* Fire once after delta_ns, replacing the previous event. */
+  void (*arm)(uint64_t delta_ns);
+  void (*stop)();
+};
+
+struct clockevent_state {
+  uint64_t deadline_ns;
+  bool armed;
+};
+
+static DEFINE_PER_CPU(struct clockevent_state, clockevent_state);
+
+static const struct clockevent_device *clockevent_device;
+
+/* Rate of the local APIC timer after its divider. */
+static uint32_t clockevent_lapic_khz;
+
+/**
+ * @brief Convert nanoseconds up to CLOCKEVENT_MAX_DELTA_NS to ticks
+ * of a timer, rounding up so that it does not fire early.
+ */
+static inline uint64_t clockevent_ns_to_ticks(uint64_t ns, uint32_t khz) {
+  return div_u64_u32(ns * khz + NSEC_PER_MSEC - 1, NSEC_PER_MSEC);
+}
+
+static void clockevent_tsc_deadline_init_cpu() {
+  lapic_timer_init(CLOCKEVENT_LAPIC_VECTOR, true);
+}
+
+static void clockevent_tsc_deadline_arm(uint64_t delta_ns) {
+  /* Deadline is never 0, which would disarm the timer. */
+  lapic_timer_arm_deadline(x86_rdtsc() + 1 +
+                           clockevent_ns_to_ticks(delta_ns, ktime_tsc_khz()));
+}
+
+static void clockevent_tsc_deadline_stop() { lapic_timer_arm_deadline(0); }
+
+static void clockevent_lapic_init_cpu() {
+  lapic_timer_init(CLOCKEVENT_LAPIC_VECTOR, false);
+}
+
+static void clockevent_lapic_arm(uint64_t delta_ns) {
+  const uint64_t count = clockevent_ns_to_ticks(delta_ns, clockevent_lapic_khz);
+
+  /* Count of 0 would disarm the timer. */
+  if (count == 0)
+    lapic_timer_arm(1);
+  else if (count > UINT32_MAX)
+    lapic_timer_arm(UINT32_MAX);
+  else
+    lapic_timer_arm((uint32_t)count);
+}
+
+static void clockevent_lapic_stop() { lapic_timer_arm(0); }
+
+static void clockevent_pit_arm(uint64_t delta_ns) {
+  const uint64_t ticks =
+      div_u64_u32(delta_ns * PIT_FREQUENCY_HZ + NSEC_PER_SEC - 1, NSEC_PER_SEC);
+
+  /* delta_ns is within CLOCKEVENT_PIT_MAX_DELTA_NS, so ticks fit. */
+  pit_oneshot(ticks == 0 ? 1 : (uint16_t)ticks);
+}
+
+static const struct clockevent_device clockevent_tsc_deadline = {
+    .name = "local APIC timer in TSC-deadline mode",
+    .max_delta_ns = CLOCKEVENT_MAX_DELTA_NS,
+    .init_cpu = clockevent_tsc_deadline_init_cpu,
+    .arm = clockevent_tsc_deadline_arm,
+    .stop = clockevent_tsc_deadline_stop,
+};
+
+static const struct clockevent_device clockevent_lapic = {
+    .name = "local APIC timer in one-shot mode",
+    .max_delta_ns = CLOCKEVENT_MAX_DELTA_NS,
+    .init_cpu = clockevent_lapic_init_cpu,
+    .arm = clockevent_lapic_arm,
+    .stop = clockevent_lapic_stop,
+};
+
+static const struct clockevent_device clockevent_pit = {
+    .name = "PIT in one-shot mode",
+    .max_delta_ns = CLOCKEVENT_PIT_MAX_DELTA_NS,
+    .init_cpu = NULL,
+    .arm = clockevent_pit_arm,
+    .stop = pit_stop,
+};
+
+static void clockevent_arm(const struct clockevent_device *device,
+                           const struct clockevent_state *state,
+                           uint64_t now) {
+  uint64_t delta_ns = state->deadline_ns > now ? state->deadline_ns - now : 0;
+
+  if (delta_ns > device->max_delta_ns)
+    delta_ns = device->max_delta_ns;
+
+  device->arm(delta_ns);
+}
+
+/**
+ * @brief Raise SOFTIRQ_TIMER if the deadline is reached,
+ * or arm the timer again if it stopped short of the deadline.
+ */
+static void clockevent_expire() {
+  struct clockevent_state *state = this_cpu_ptr(clockevent_state);
+  const uint64_t now = ktime_get_ns();
+
+  /* Event may be cancelled after the interrupt is raised. */
+  if (!state->armed)
+    return;
+
+  if (now < state->deadline_ns) {
+    clockevent_arm(__atomic_load_n(&clockevent_device, __ATOMIC_ACQUIRE),
+                   state, now);
+    return;
+  }
+
+  state->armed = false;
+  softirq_raise(SOFTIRQ_TIMER);
+}
+
+static void irq_handler_lapic_timer(struct trap_frame *frame, void *ctx) {
+  lapic_eoi();
+  clockevent_expire();
+}
+
+static void irq_handler_pit(struct trap_frame *frame, void *ctx) {
+  irq_notify_eoi(frame);
+  clockevent_expire();
+}
+
+/**
+ * @brief Measure the rate of the local APIC timer, which runs
+ * on the bus clock instead of the time stamp counter.
+ *
+ * @return int 0 on success, or -1 if the timer does not count.
+ */
+static int clockevent_lapic_calibrate() {
+  unsigned long flags;
+  uint64_t start, elapsed_ns;
+  uint32_t count;
+
+  lapic_timer_init(CLOCKEVENT_LAPIC_VECTOR, false);
+
+  flags = x86_irq_save();
+  lapic_timer_arm(UINT32_MAX);
+  start = ktime_get_ns();
+  while ((elapsed_ns = ktime_get_ns() - start) < CLOCKEVENT_LAPIC_CALIBRATE_NS)
+    x86_pause();
+  count = UINT32_MAX - lapic_timer_count();
+  lapic_timer_arm(0);
+  x86_irq_restore(flags);
+
+  clockevent_lapic_khz = (uint32_t)div_u64_u32((uint64_t)count * NSEC_PER_MSEC,
+                                               (uint32_t)elapsed_ns);
+  return clockevent_lapic_khz == 0 ? -1 : 0;
+}
+
+int clockevent_init() {
+  const struct clockevent_device *device = &clockevent_pit;
+
+  /* Deadlines are in ktime, which needs a calibrated time stamp counter. */
+  if (ktime_tsc_khz() == 0)
+    return -1;
+
+  if (lapic_init() == 0) {
+    lapic_enable();
+
+    if (lapic_tsc_deadline_supported())
+      device = &clockevent_tsc_deadline;
+    else if (clockevent_lapic_calibrate() == 0)
+      device = &clockevent_lapic;
+  }
+
+  /* Firmware leaves channel 0 periodic, which would keep waking up. */
+  pit_stop();
+
+  if (device->init_cpu != NULL) {
+    irq_register(CLOCKEVENT_LAPIC_VECTOR, irq_handler_lapic_timer, NULL);
+    device->init_cpu();
+  } else {
+    irq_register(IDT_VECTOR_PIT, irq_handler_pit, NULL);
+  }
+
+  __atomic_store_n(&clockevent_device, device, __ATOMIC_RELEASE);
+
+  terminal_printk("Clock events: %s\n", device->name);
+  return 0;
+}
+
+void clockevent_init_ap() {
+  const struct clockevent_device *device =
+      __atomic_load_n(&clockevent_device, __ATOMIC_ACQUIRE);
+
+  if (device != NULL && device->init_cpu != NULL)
+    device->init_cpu();
+}
+
+bool clockevent_per_cpu() {
+  const struct clockevent_device *device =
+      __atomic_load_n(&clockevent_device, __ATOMIC_ACQUIRE);
+
+  return device != NULL && device->init_cpu != NULL;
+}
+
+void clockevent_program(uint64_t deadline_ns) {
+  const struct clockevent_device *device =
+      __atomic_load_n(&clockevent_device, __ATOMIC_ACQUIRE);
+  struct clockevent_state *state;
+  unsigned long flags;
+
+  if (device == NULL)
+    return;
+
+  /* Shared timer only interrupts the bootstrap processor. */
+  if (device->init_cpu == NULL && smp_processor_id() != 0)
+    return;
+
+  flags = x86_irq_save();
+  state = this_cpu_ptr(clockevent_state);
+  state->deadline_ns = deadline_ns;
+  state->armed = true;
+  clockevent_arm(device, state, ktime_get_ns());
+  x86_irq_restore(flags);
+}
+
+void clockevent_cancel() {
+  const struct clockevent_device *device =
+      __atomic_load_n(&clockevent_device, __ATOMIC_ACQUIRE);
+  struct clockevent_state *state;
+  unsigned long flags;
+
+  if (device == NULL)
+    return;
+
+  flags = x86_irq_save();
+  state = this_cpu_ptr(clockevent_state);
+  if (state->armed) {
+    state->armed = false;
+    device->stop();
+  }
+  x86_irq_restore(flags);
+}
@@ -0,0 +1,55 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include <acpi/acpi.h>
+#include <memory/paging.h>
+#include <time/hpet.h>
+
+/* Upper half of the capabilities, which is the counter period. */
+#define HPET_REG_CAPABILITIES_PERIOD 0x004
+#define HPET_REG_CONFIG 0x010
+#define HPET_REG_MAIN_COUNTER 0x0F0
+
+#define HPET_CONFIG_ENABLE (1U << 0)
+
+/* Period is at most 100ns by the specification. */
+#define HPET_PERIOD_MAX_FS 100000000U
+
+static volatile uint32_t *hpet_base;
+static uint32_t hpet_period;
+
+static inline uint32_t hpet_read(uint32_t reg) {
+  return hpet_base[reg / sizeof(*hpet_base)];
+}
+
+static inline void hpet_write(uint32_t reg, uint32_t value) {
+  hpet_base[reg / sizeof(*hpet_base)] = value;
+}
+
+int hpet_init() {
+  const struct acpi_hpet *hpet =
+      (const struct acpi_hpet *)acpi_find_table(HPET_SIGNATURE);
+  uint64_t addr;
+
+  if (hpet == NULL || hpet->header.length < sizeof(*hpet) ||
+      hpet->address.space_id != ACPI_ADDRESS_SPACE_MEMORY)
+    return -1;
+
+  addr = hpet->address.address;
+  if (!paging_mmio_mapped(addr))
+    return -1;
+
+  hpet_base = (volatile uint32_t *)(uintptr_t)addr;
+  hpet_period = hpet_read(HPET_REG_CAPABILITIES_PERIOD);
+  if (hpet_period == 0 || hpet_period > HPET_PERIOD_MAX_FS) {
+    hpet_base = NULL;
+    return -1;
+  }
+
+  hpet_write(HPET_REG_CONFIG, hpet_read(HPET_REG_CONFIG) | HPET_CONFIG_ENABLE);
+  return 0;
+}
+
+uint32_t hpet_period_fs() { return hpet_period; }
+
+uint32_t hpet_read_counter() { return hpet_read(HPET_REG_MAIN_COUNTER); }
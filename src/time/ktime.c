@@ -0,0 +1,113 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+#include <display/display.h>
+#include <math64.h>
+#include <sync/seqlock.h>
+#include <sync/spinlock.h>
+#include <time/ktime.h>
+#include <time/tsc.h>
+
+/**
+ * Time is base_ns plus the cycles since base_tsc, converted with
+ * (cycles * mult) >> shift, so that reading it needs no division.
+ * Readers go through the sequence counter, since 64 bit fields
+ * cannot be read atomically on the 32 bit kernel.
+ */
+struct timekeeper {
+  struct seqlock seq;
+  uint64_t base_tsc;
+  uint64_t base_ns;
+  uint32_t mult;
+  uint32_t shift;
+  uint32_t tsc_khz;
+};
+
+static struct timekeeper timekeeper = {.seq = SEQLOCK_INIT};
+
+/* Serializes writers of timekeeper. */
+static struct spinlock timekeeper_lock = SPINLOCK_INIT;
+
+static inline uint64_t timekeeper_delta_ns(const struct timekeeper *tk,
+                                           uint64_t tsc) {
+  /* Processor may be slightly behind the one which set the base. */
+  if (tsc < tk->base_tsc)
+    return 0;
+  return mul_u64_u32_shr(tsc - tk->base_tsc, tk->mult, tk->shift);
+}
+
+uint64_t ktime_get_ns() {
+  uint32_t sequence;
+  uint64_t ns;
+
+  do {
+    sequence = read_seqbegin(&timekeeper.seq);
+    ns = timekeeper.base_ns + timekeeper_delta_ns(&timekeeper, x86_rdtsc());
+  } while (read_seqretry(&timekeeper.seq, sequence));
+
+  return ns;
+}
+
+uint64_t ktime_cycles_to_ns(uint64_t cycles) {
+  uint32_t sequence, mult, shift;
+
+  do {
+    sequence = read_seqbegin(&timekeeper.seq);
+    mult = timekeeper.mult;
+    shift = timekeeper.shift;
+  } while (read_seqretry(&timekeeper.seq, sequence));
+
+  return mul_u64_u32_shr(cycles, mult, shift);
+}
+
+uint32_t ktime_tsc_khz() {
+  return __atomic_load_n(&timekeeper.tsc_khz, __ATOMIC_RELAXED);
+}
+
+void ktime_set_tsc_khz(uint32_t tsc_khz) {
+  uint32_t shift;
+  uint64_t mult = 0;
+  unsigned long flags;
+
+  /* Largest shift where mult fits in 32 bits, for the best precision. */
+  for (shift = 32; shift > 0; --shift) {
+    mult = div_u64_u32((uint64_t)NSEC_PER_MSEC << shift, tsc_khz);
+    if (mult <= UINT32_MAX)
+      break;
+  }
+
+  flags = spin_lock_irqsave(&timekeeper_lock);
+  write_seqbegin(&timekeeper.seq);
+
+  if (timekeeper.tsc_khz == 0) {
+    /* Time before the first calibration counts from the reset. */
+    timekeeper.base_tsc = 0;
+    timekeeper.base_ns = 0;
+  } else {
+    const uint64_t now = x86_rdtsc();
+
+    timekeeper.base_ns += timekeeper_delta_ns(&timekeeper, now);
+    timekeeper.base_tsc = now;
+  }
+  timekeeper.mult = (uint32_t)mult;
+  timekeeper.shift = shift;
+  timekeeper.tsc_khz = tsc_khz;
+
+  write_seqend(&timekeeper.seq);
+  spin_unlock_irqrestore(&timekeeper_lock, flags);
+}
+
+int ktime_init() {
+  const uint32_t tsc_khz = tsc_calibrate();
+
+  if (tsc_khz == 0)
+    return -1;
+
+  ktime_set_tsc_khz(tsc_khz);
+
+  terminal_printk("TSC: %u.%03u MHz%s\n", (unsigned int)(tsc_khz / 1000),
+                  (unsigned int)(tsc_khz % 1000),
+                  tsc_invariant() ? "" : ", not invariant");
+  return 0;
+}
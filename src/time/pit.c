@@ -0,0 +1,63 @@
+#include <stdint.h>
+
+#include <io/io.h>
+#include <time/pit.h>
+
+#define PIT_CHANNEL0_DATA_PORT 0x40
+#define PIT_CHANNEL2_DATA_PORT 0x42
+#define PIT_COMMAND_PORT 0x43
+#define PIT_CHANNEL2_GATE_PORT 0x61
+
+#define PIT_COMMAND_CHANNEL0 (0U << 6)
+#define PIT_COMMAND_CHANNEL2 (2U << 6)
+#define PIT_COMMAND_ACCESS_LOHI (3U << 4)
+#define PIT_COMMAND_MODE_ONESHOT (0U << 1)
+
+#define PIT_GATE_CHANNEL2 (1U << 0)
+#define PIT_GATE_SPEAKER (1U << 1)
+#define PIT_GATE_CHANNEL2_OUT (1U << 5)
+
+/* Counter is 16 bit wide, so long delays are split into chunks. */
+#define PIT_DELAY_CHUNK_US 50000U
+
+void pit_delay_ticks(uint16_t ticks) {
+  uint8_t gate = x86_inb(PIT_CHANNEL2_GATE_PORT);
+
+  /* Output of channel 2 rises when the count reaches zero. */
+  x86_outb(PIT_CHANNEL2_GATE_PORT,
+           (gate & ~PIT_GATE_SPEAKER) | PIT_GATE_CHANNEL2);
+  x86_outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL2 | PIT_COMMAND_ACCESS_LOHI |
+                                 PIT_COMMAND_MODE_ONESHOT);
+  x86_outb(PIT_CHANNEL2_DATA_PORT, (uint8_t)ticks);
+  x86_outb(PIT_CHANNEL2_DATA_PORT, (uint8_t)(ticks >> 8));
+
+  while (!(x86_inb(PIT_CHANNEL2_GATE_PORT) & PIT_GATE_CHANNEL2_OUT)) {
+  }
+
+  x86_outb(PIT_CHANNEL2_GATE_PORT, gate);
+}
+
+void pit_delay_us(uint32_t us) {
+  while (us > 0) {
+    uint32_t chunk = us < PIT_DELAY_CHUNK_US ? us : PIT_DELAY_CHUNK_US;
+    /* Round up, so that the delay is never shorter than asked. */
+    uint32_t ticks = (chunk * (PIT_FREQUENCY_HZ / 1000) + 999) / 1000;
+
+    pit_delay_ticks((uint16_t)ticks);
+    us -= chunk;
+  }
+}
+
+void pit_oneshot(uint16_t ticks) {
+  /* Output of channel 0 rises once when the count reaches zero. */
+  x86_outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL0 | PIT_COMMAND_ACCESS_LOHI |
+                                 PIT_COMMAND_MODE_ONESHOT);
+  x86_outb(PIT_CHANNEL0_DATA_PORT, (uint8_t)ticks);
+  x86_outb(PIT_CHANNEL0_DATA_PORT, (uint8_t)(ticks >> 8));
+}
+
+void pit_stop() {
+  /* Counter does not start until a count is written after the command. */
+  x86_outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL0 | PIT_COMMAND_ACCESS_LOHI |
+                                 PIT_COMMAND_MODE_ONESHOT);
+}
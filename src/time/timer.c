@@ -0,0 +1,297 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+#include <cpu/percpu.h>
+#include <idt/softirq.h>
+#include <sync/spinlock.h>
+#include <time/clockevent.h>
+#include <time/ktime.h>
+#include <time/timer.h>
+
+/* Ticks are 2^20 ns, about a millisecond, so that no division is needed. */
+#define TIMER_TICK_SHIFT 20
+
+/**
+ * First level has a slot for each of the next 256 ticks. Each further
+ * level has 64 slots, each as wide as the whole level below, and timers
+ * move down a level when their slot comes up. Four levels cover 2^26 ticks,
+ * about 19 hours, and later timers wait in the last slot.
+ */
+#define TIMER_LEVELS 4
+#define TIMER_LEVEL0_BITS 8
+#define TIMER_LEVEL_BITS 6
+#define TIMER_LEVEL0_SIZE (1U << TIMER_LEVEL0_BITS)
+#define TIMER_LEVEL_SIZE (1U << TIMER_LEVEL_BITS)
+
+/* Ticks covered by the levels below the level. */
+#define TIMER_LEVEL_SHIFT(level)                                               \
+  (TIMER_LEVEL0_BITS + ((level)-1) * TIMER_LEVEL_BITS)
+#define TIMER_RANGE ((uint64_t)1 << TIMER_LEVEL_SHIFT(TIMER_LEVELS))
+
+struct timer_wheel {
+  struct spinlock lock;
+  /* Next tick to run, which timers before it are put in. */
+  uint64_t clk;
+  /* Tick the clock event is programmed for, if any. */
+  uint64_t event_tick;
+  bool event_armed;
+  /* Timer whose callback is running, which is only compared against. */
+  const struct timer *running;
+  struct timer *level0[TIMER_LEVEL0_SIZE];
+  struct timer *levels[TIMER_LEVELS - 1][TIMER_LEVEL_SIZE];
+};
+
+static DEFINE_PER_CPU(struct timer_wheel, timer_wheel);
+
+static inline uint64_t timer_tick_ns(uint64_t tick) {
+  return tick << TIMER_TICK_SHIFT;
+}
+
+static void timer_link(struct timer **slot, struct timer *timer) {
+  timer->next = *slot;
+  if (timer->next != NULL)
+    timer->next->pprev = &timer->next;
+  *slot = timer;
+  timer->pprev = slot;
+}
+
+static void timer_unlink(struct timer *timer) {
+  *timer->pprev = timer->next;
+  if (timer->next != NULL)
+    timer->next->pprev = timer->pprev;
+  timer->next = NULL;
+  timer->pprev = NULL;
+}
+
+/**
+ * @brief Slot for a timer expiring at the tick, which depends on
+ * how far the tick is from clk.
+ */
+static struct timer **timer_wheel_slot(struct timer_wheel *wheel,
+                                       uint64_t expires) {
+  uint64_t delta;
+
+  if (expires < wheel->clk)
+    expires = wheel->clk;
+  delta = expires - wheel->clk;
+
+  if (delta < TIMER_LEVEL0_SIZE)
+    return &wheel->level0[expires & (TIMER_LEVEL0_SIZE - 1)];
+
+  if (delta >= TIMER_RANGE)
+    expires = wheel->clk + TIMER_RANGE - 1;
+
+  for (unsigned int level = 1;; ++level) {
+    if (level == TIMER_LEVELS - 1 ||
+        delta < ((uint64_t)1 << TIMER_LEVEL_SHIFT(level + 1)))
+      return &wheel->levels[level - 1][(expires >> TIMER_LEVEL_SHIFT(level)) &
+                                       (TIMER_LEVEL_SIZE - 1)];
+  }
+}
+
+/**
+ * @brief Earliest tick from clk where a timer expires or moves down
+ * a level, or UINT64_MAX if the wheel is empty.
+ */
+static uint64_t timer_wheel_next(const struct timer_wheel *wheel) {
+  uint64_t next = UINT64_MAX;
+
+  for (unsigned int i = 0; i < TIMER_LEVEL0_SIZE; ++i) {
+    const uint64_t tick = wheel->clk + i;
+
+    if (wheel->level0[tick & (TIMER_LEVEL0_SIZE - 1)] != NULL) {
+      next = tick;
+      break;
+    }
+  }
+
+  for (unsigned int level = 1; level < TIMER_LEVELS; ++level) {
+    const unsigned int shift = TIMER_LEVEL_SHIFT(level);
+    /* Each slot moves down at one of the next 64 boundaries from clk. */
+    const uint64_t first = (wheel->clk + ((uint64_t)1 << shift) - 1) >> shift;
+
+    for (unsigned int i = 0; i < TIMER_LEVEL_SIZE; ++i) {
+      const uint64_t boundary = first + i;
+
+      if (wheel->levels[level - 1][boundary & (TIMER_LEVEL_SIZE - 1)] !=
+          NULL) {
+        if ((boundary << shift) < next)
+          next = boundary << shift;
+        break;
+      }
+    }
+  }
+
+  return next;
+}
+
+/**
+ * @brief Move timers of higher level slots which come up at clk
+ * down to where they belong now.
+ */
+static void timer_wheel_cascade(struct timer_wheel *wheel) {
+  for (unsigned int level = TIMER_LEVELS - 1; level > 0; --level) {
+    const unsigned int shift = TIMER_LEVEL_SHIFT(level);
+    struct timer **slot;
+    struct timer *list;
+
+    if (wheel->clk & (((uint64_t)1 << shift) - 1))
+      continue;
+
+    slot = &wheel->levels[level - 1][(wheel->clk >> shift) &
+                                     (TIMER_LEVEL_SIZE - 1)];
+    list = *slot;
+    *slot = NULL;
+
+    while (list != NULL) {
+      struct timer *timer = list;
+
+      list = timer->next;
+      timer_link(timer_wheel_slot(wheel, timer->expires), timer);
+    }
+  }
+}
+
+static void timer_wheel_program(struct timer_wheel *wheel, uint64_t tick) {
+  if (tick == UINT64_MAX) {
+    if (wheel->event_armed)
+      clockevent_cancel();
+    wheel->event_armed = false;
+    return;
+  }
+
+  wheel->event_tick = tick;
+  wheel->event_armed = true;
+  clockevent_program(timer_tick_ns(tick));
+}
+
+/**
+ * @brief Run the timers expired on the calling processor.
+ *
+ * Ticks with nothing to do are skipped, so that catching up
+ * after a long idle period takes no longer than a short one.
+ */
+static void timer_softirq() {
+  const uint64_t now = ktime_get_ns() >> TIMER_TICK_SHIFT;
+  struct timer_wheel *wheel;
+  unsigned long flags;
+  uint64_t next;
+
+  flags = x86_irq_save();
+  wheel = this_cpu_ptr(timer_wheel);
+  spin_lock(&wheel->lock);
+  wheel->event_armed = false;
+
+  while ((next = timer_wheel_next(wheel)) <= now) {
+    struct timer **slot;
+    struct timer *expired;
+
+    wheel->clk = next;
+    timer_wheel_cascade(wheel);
+
+    /**
+     * Slot is taken off the wheel as a whole, and each timer is
+     * unlinked from it with the lock held, so that cancelling
+     * a timer of the batch still works while callbacks run.
+     */
+    slot = &wheel->level0[next & (TIMER_LEVEL0_SIZE - 1)];
+    expired = *slot;
+    *slot = NULL;
+    if (expired != NULL)
+      expired->pprev = &expired;
+    wheel->clk = next + 1;
+
+    while (expired != NULL) {
+      struct timer *timer = expired;
+      const timer_fn_t fn = timer->fn;
+      void *const ctx = timer->ctx;
+
+      timer_unlink(timer);
+      __atomic_store_n(&timer->wheel, NULL, __ATOMIC_RELEASE);
+      __atomic_store_n(&wheel->running, timer, __ATOMIC_RELAXED);
+
+      spin_unlock_irqrestore(&wheel->lock, flags);
+      fn(ctx);
+      flags = x86_irq_save();
+      spin_lock(&wheel->lock);
+      /* Timer may be gone by now, so it is not touched. */
+      __atomic_store_n(&wheel->running, NULL, __ATOMIC_RELEASE);
+    }
+  }
+
+  if (wheel->clk <= now)
+    wheel->clk = now + 1;
+  timer_wheel_program(wheel, next);
+
+  spin_unlock_irqrestore(&wheel->lock, flags);
+}
+
+void timer_init() { softirq_register(SOFTIRQ_TIMER, timer_softirq); }
+
+void timer_add(struct timer *timer, uint64_t deadline_ns, timer_fn_t fn,
+               void *ctx) {
+  /* Round up, so that the timer never expires before the deadline. */
+  const uint64_t expires =
+      (deadline_ns + ((uint64_t)1 << TIMER_TICK_SHIFT) - 1) >> TIMER_TICK_SHIFT;
+  struct timer_wheel *wheel;
+  unsigned long flags;
+
+  timer_cancel(timer);
+
+  flags = x86_irq_save();
+  wheel = this_cpu_ptr(timer_wheel);
+  spin_lock(&wheel->lock);
+
+  timer->expires = expires;
+  timer->fn = fn;
+  timer->ctx = ctx;
+  timer_link(timer_wheel_slot(wheel, expires), timer);
+  timer->last_wheel = wheel;
+  __atomic_store_n(&timer->wheel, wheel, __ATOMIC_RELEASE);
+
+  if (!wheel->event_armed || expires < wheel->event_tick)
+    timer_wheel_program(wheel, expires);
+
+  spin_unlock_irqrestore(&wheel->lock, flags);
+}
+
+bool timer_cancel(struct timer *timer) {
+  struct timer_wheel *wheel;
+  unsigned long flags;
+
+  /* Timer may move to another wheel until the lock is taken. */
+  while (1) {
+    wheel = __atomic_load_n(&timer->wheel, __ATOMIC_ACQUIRE);
+    if (wheel == NULL)
+      return false;
+
+    flags = spin_lock_irqsave(&wheel->lock);
+    if (timer->wheel == wheel)
+      break;
+    spin_unlock_irqrestore(&wheel->lock, flags);
+  }
+
+  /* Clock event is left alone, and finds nothing to do if it fires. */
+  timer_unlink(timer);
+  __atomic_store_n(&timer->wheel, NULL, __ATOMIC_RELAXED);
+
+  spin_unlock_irqrestore(&wheel->lock, flags);
+  return true;
+}
+
+bool timer_cancel_sync(struct timer *timer) {
+  const bool pending = timer_cancel(timer);
+  struct timer_wheel *wheel = timer->last_wheel;
+
+  if (wheel != NULL) {
+    while (__atomic_load_n(&wheel->running, __ATOMIC_ACQUIRE) == timer)
+      x86_pause();
+  }
+  return pending;
+}
+
+bool timer_pending(const struct timer *timer) {
+  return __atomic_load_n(&timer->wheel, __ATOMIC_RELAXED) != NULL;
+}
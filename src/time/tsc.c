@@ -0,0 +1,88 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <cpu/cpu.h>
+#include <math64.h>
+#include <time/hpet.h>
+#include <time/pit.h>
+#include <time/tsc.h>
+
+#define X86_CPUID_EXTENDED_POWER 0x80000007U
+#define X86_CPUID_EXTENDED_POWER_EDX_INVARIANT_TSC (1U << 8)
+
+/**
+ * Each round measures this long, and the shortest result is taken,
+ * since interference such as SMIs only makes a round longer.
+ */
+#define TSC_CALIBRATE_US 10000U
+#define TSC_CALIBRATE_ROUNDS 3
+
+#define FS_PER_NS 1000000U
+#define NS_PER_MS 1000000U
+
+bool tsc_invariant() {
+  uint32_t eax, ebx, ecx, edx;
+
+  x86_cpuid(0x80000000U, 0, &eax, &ebx, &ecx, &edx);
+  if (eax < X86_CPUID_EXTENDED_POWER)
+    return false;
+
+  x86_cpuid(X86_CPUID_EXTENDED_POWER, 0, &eax, &ebx, &ecx, &edx);
+  return edx & X86_CPUID_EXTENDED_POWER_EDX_INVARIANT_TSC;
+}
+
+static uint32_t tsc_calibrate_hpet() {
+  /* Counter ticks in a round, which stay well within 32 bits. */
+  const uint32_t ticks =
+      (uint32_t)div_u64_u32((uint64_t)TSC_CALIBRATE_US * 1000 * FS_PER_NS,
+                            hpet_period_fs());
+  uint64_t best = UINT64_MAX;
+  uint32_t elapsed_ns = 0;
+
+  for (int round = 0; round < TSC_CALIBRATE_ROUNDS; ++round) {
+    const uint32_t start = hpet_read_counter();
+    const uint64_t tsc_start = x86_rdtsc();
+    uint32_t elapsed;
+    uint64_t cycles;
+
+    while ((elapsed = hpet_read_counter() - start) < ticks)
+      x86_pause();
+    cycles = x86_rdtsc() - tsc_start;
+
+    if (cycles < best) {
+      best = cycles;
+      elapsed_ns = (uint32_t)div_u64_u32(
+          (uint64_t)elapsed * hpet_period_fs(), FS_PER_NS);
+    }
+  }
+
+  return elapsed_ns == 0 ? 0
+                         : (uint32_t)div_u64_u32(best * NS_PER_MS, elapsed_ns);
+}
+
+static uint32_t tsc_calibrate_pit() {
+  const uint16_t ticks =
+      (uint16_t)(TSC_CALIBRATE_US * (PIT_FREQUENCY_HZ / 1000) / 1000);
+  uint64_t best = UINT64_MAX;
+
+  for (int round = 0; round < TSC_CALIBRATE_ROUNDS; ++round) {
+    const uint64_t tsc_start = x86_rdtsc();
+    uint64_t cycles;
+
+    pit_delay_ticks(ticks);
+    cycles = x86_rdtsc() - tsc_start;
+
+    if (cycles < best)
+      best = cycles;
+  }
+
+  /* cycles / (ticks / PIT_FREQUENCY_HZ) / 1000 */
+  return (uint32_t)div_u64_u32(best * PIT_FREQUENCY_HZ, ticks * 1000U);
+}
+
+uint32_t tsc_calibrate() {
+  if (hpet_init() == 0)
+    return tsc_calibrate_hpet();
+
+  return tsc_calibrate_pit();
+}
@@ -0,0 +1,117 @@
+// make test, or:
+// cc -std=gnu11 -Iinclude -o e820_test test/boot/e820_test.c && ./e820_test
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/boot/e820.c"
+
+#define ENTRY(b, l, t)                                                         \
+  { .base = (b), .length = (l), .type = (t), .attr = E820_ATTR_ENABLED }
+
+static int failures;
+
+static void expect_sanitize(const char *name, const struct e820_entry *src,
+                            uint32_t count, const struct e820_entry *expect,
+                            uint32_t expect_count, uint32_t max) {
+  struct e820_entry dst[2 * E820_ENTRY_MAX];
+  uint32_t ndst = e820_sanitize(src, count, dst, max);
+
+  if (ndst != expect_count) {
+    printf("%s: got %u entries, expected %u\n", name, ndst, expect_count);
+    failures++;
+    return;
+  }
+
+  for (uint32_t i = 0; i < ndst; ++i) {
+    if (dst[i].base != expect[i].base || dst[i].length != expect[i].length ||
+        dst[i].type != expect[i].type) {
+      printf("%s: entry %u is %llx+%llx type %u, expected %llx+%llx type %u\n",
+             name, i, (unsigned long long)dst[i].base,
+             (unsigned long long)dst[i].length, dst[i].type,
+             (unsigned long long)expect[i].base,
+             (unsigned long long)expect[i].length, expect[i].type);
+      failures++;
+    }
+  }
+}
+
+static void test_sort_and_merge() {
+  const struct e820_entry src[] = {
+      ENTRY(0x100000, 0x100000, E820_TYPE_USABLE),
+      ENTRY(0x0, 0x9F000, E820_TYPE_USABLE),
+      ENTRY(0x200000, 0x100000, E820_TYPE_USABLE),
+      ENTRY(0xF0000, 0x10000, E820_TYPE_RESERVED),
+  };
+  const struct e820_entry expect[] = {
+      ENTRY(0x0, 0x9F000, E820_TYPE_USABLE),
+      ENTRY(0xF0000, 0x10000, E820_TYPE_RESERVED),
+      ENTRY(0x100000, 0x200000, E820_TYPE_USABLE),
+  };
+
+  expect_sanitize("sort and merge", src, 4, expect, 3, E820_ENTRY_MAX);
+}
+
+static void test_overlap() {
+  /* Reserved and ACPI ranges in the middle of usable memory win. */
+  const struct e820_entry src[] = {
+      ENTRY(0x0, 0x1000000, E820_TYPE_USABLE),
+      ENTRY(0x400000, 0x200000, E820_TYPE_RESERVED),
+      ENTRY(0x500000, 0x200000, E820_TYPE_ACPI_RECLAIMABLE),
+      ENTRY(0xFFF000, 0x2000, E820_TYPE_BAD),
+  };
+  const struct e820_entry expect[] = {
+      ENTRY(0x0, 0x400000, E820_TYPE_USABLE),
+      ENTRY(0x400000, 0x200000, E820_TYPE_RESERVED),
+      ENTRY(0x600000, 0x100000, E820_TYPE_ACPI_RECLAIMABLE),
+      ENTRY(0x700000, 0x8FF000, E820_TYPE_USABLE),
+      ENTRY(0xFFF000, 0x2000, E820_TYPE_BAD),
+  };
+
+  expect_sanitize("overlap", src, 4, expect, 5, E820_ENTRY_MAX);
+}
+
+static void test_skipped_entries() {
+  /* Empty and disabled entries are dropped, and unknown types reserved. */
+  const struct e820_entry src[] = {
+      ENTRY(0x0, 0x100000, E820_TYPE_USABLE),
+      ENTRY(0x80000, 0, E820_TYPE_RESERVED),
+      {.base = 0x40000, .length = 0x1000, .type = E820_TYPE_BAD, .attr = 0},
+      ENTRY(0x100000, 0x1000, 12),
+  };
+  const struct e820_entry expect[] = {
+      ENTRY(0x0, 0x100000, E820_TYPE_USABLE),
+      ENTRY(0x100000, 0x1000, E820_TYPE_RESERVED),
+  };
+
+  expect_sanitize("skipped entries", src, 4, expect, 2, E820_ENTRY_MAX);
+}
+
+static void test_wrap_and_limit() {
+  const struct e820_entry src[] = {
+      ENTRY(0x0, 0x1000, E820_TYPE_USABLE),
+      ENTRY(0x2000, 0x1000, E820_TYPE_RESERVED),
+      ENTRY(0xFFFFFFFFFFFFF000ULL, 0x2000, E820_TYPE_RESERVED),
+  };
+  const struct e820_entry expect[] = {
+      ENTRY(0x0, 0x1000, E820_TYPE_USABLE),
+      ENTRY(0x2000, 0x1000, E820_TYPE_RESERVED),
+      ENTRY(0xFFFFFFFFFFFFF000ULL, 0xFFF, E820_TYPE_RESERVED),
+  };
+
+  /* Entries running past the end are cut at the top of the address space. */
+  expect_sanitize("wrap", src, 3, expect, 3, E820_ENTRY_MAX);
+  /* Entries beyond max are dropped. */
+  expect_sanitize("limit", src, 3, expect, 2, 2);
+}
+
+int main() {
+  test_sort_and_merge();
+  test_overlap();
+  test_skipped_entries();
+  test_wrap_and_limit();
+
+  if (failures != 0)
+    return EXIT_FAILURE;
+  printf("e820_test passed.\n");
+  return EXIT_SUCCESS;
+}
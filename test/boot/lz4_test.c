@@ -0,0 +1,111 @@
+// make test, or:
+// cc -std=gnu11 -Iinclude -o lz4_test test/boot/lz4_test.c && ./lz4_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/boot/lz4.c"
+
+static int failures;
+
+static void expect_decompress(const char *name, const uint8_t *src,
+                              uint32_t src_size, const void *expect,
+                              int expect_size, uint32_t dst_size) {
+  uint8_t dst[1024];
+  int ret;
+
+  memset(dst, 0xCC, sizeof(dst));
+  ret = lz4_decompress(src, src_size, dst, dst_size);
+
+  if (ret != expect_size ||
+      (expect_size > 0 && memcmp(dst, expect, expect_size) != 0)) {
+    printf("%s: got %d, expected %d\n", name, ret, expect_size);
+    failures++;
+  }
+
+  /* Nothing is written past the buffer. */
+  if (dst_size < sizeof(dst) && dst[dst_size] != 0xCC) {
+    printf("%s: wrote past the buffer\n", name);
+    failures++;
+  }
+}
+
+static void test_literals() {
+  static const uint8_t block[] = {0x50, 'h', 'e', 'l', 'l', 'o'};
+
+  expect_decompress("literals", block, sizeof(block), "hello", 5, 64);
+  expect_decompress("literals exact", block, sizeof(block), "hello", 5, 5);
+  expect_decompress("literals overflow", block, sizeof(block), NULL, -1, 4);
+  expect_decompress("empty", block, 0, NULL, 0, 64);
+}
+
+static void test_match() {
+  /* "abcd" then a copy of it from offset 4, then literals "xyz". */
+  static const uint8_t block[] = {0x40, 'a', 'b', 'c', 'd', 0x04, 0x00,
+                                  0x30, 'x', 'y', 'z'};
+
+  expect_decompress("match", block, sizeof(block), "abcdabcdxyz", 11, 64);
+  expect_decompress("match overflow", block, sizeof(block), NULL, -1, 7);
+}
+
+static void test_overlapping_match() {
+  /* Run of 'a' from offset 1, and of "ab" from offset 2. */
+  static const uint8_t run[] = {0x13, 'a', 0x01, 0x00, 0x00};
+  static const uint8_t pair[] = {0x22, 'a', 'b', 0x02, 0x00, 0x00};
+
+  expect_decompress("offset 1", run, sizeof(run), "aaaaaaaa", 8, 64);
+  expect_decompress("offset 2", pair, sizeof(pair), "abababab", 8, 64);
+}
+
+static void test_long_lengths() {
+  uint8_t block[512], expect[1024];
+  uint32_t ip = 0;
+
+  /* 15 + 255 + 10 literals, then a match of 4 + 15 + 255 + 1. */
+  block[ip++] = 0xFF;
+  block[ip++] = 0xFF;
+  block[ip++] = 10;
+  for (int i = 0; i < 280; ++i)
+    block[ip++] = expect[i] = (uint8_t)i;
+  block[ip++] = 0x18;
+  block[ip++] = 0x01;
+  block[ip++] = 0xFF;
+  block[ip++] = 0x01;
+  for (int i = 280; i < 280 + 275; ++i)
+    expect[i] = expect[i - 0x118];
+  block[ip++] = 0x00;
+
+  expect_decompress("long lengths", block, ip, expect, 555, sizeof(expect));
+}
+
+static void test_malformed() {
+  static const uint8_t zero_offset[] = {0x10, 'a', 0x00, 0x00, 0x00};
+  static const uint8_t far_offset[] = {0x10, 'a', 0x02, 0x00, 0x00};
+  static const uint8_t short_literals[] = {0x50, 'a', 'b'};
+  static const uint8_t short_offset[] = {0x10, 'a', 0x01};
+  static const uint8_t short_length[] = {0xF0, 0xFF};
+
+  expect_decompress("zero offset", zero_offset, sizeof(zero_offset), NULL,
+                    -1, 64);
+  expect_decompress("far offset", far_offset, sizeof(far_offset), NULL, -1,
+                    64);
+  expect_decompress("short literals", short_literals, sizeof(short_literals),
+                    NULL, -1, 64);
+  expect_decompress("short offset", short_offset, sizeof(short_offset), NULL,
+                    -1, 64);
+  expect_decompress("short length", short_length, sizeof(short_length), NULL,
+                    -1, 64);
+}
+
+int main() {
+  test_literals();
+  test_match();
+  test_overlapping_match();
+  test_long_lengths();
+  test_malformed();
+
+  if (failures != 0)
+    return EXIT_FAILURE;
+  printf("lz4_test passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -2469,5 +2469,10 @@ void vcbprintf_test() {
   test.test(".     1.", ".%+ #06.0u.", 1);
   test.test(".1     .", ".%-+ #06.0u.", 1);
 
+  terminal_print("vcbprintf_test string start.\n");
+  test.test(".abc.", ".%s.", "abc");
+  test.test("..", ".%s.", "");
+  test.test(".a1bc.", ".%s%d%s.", "a", 1, "bc");
+
   terminal_print("vcbprintf_test finished.\n");
 }
\ No newline at end of file
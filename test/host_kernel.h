@@ -0,0 +1,59 @@
+#ifndef HOST_KERNEL_H
+#define HOST_KERNEL_H
+
+/**
+ * Stand-ins for <cpu/cpu.h> and <cpu/percpu.h>, so that kernel code
+ * which only needs interrupt control and per-CPU variables builds
+ * on the host. This should be included before the code under test.
+ *
+ * Each host thread plays a processor, with its own copy of per-CPU
+ * variables, and an interrupt flag which nothing but the code under test
+ * looks at.
+ */
+#define CPU_H
+#define PERCPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define X86_EFLAGS_IF (1U << 9)
+
+static __thread unsigned long host_eflags = X86_EFLAGS_IF;
+
+static inline void x86_pause() { __builtin_ia32_pause(); }
+
+static inline void x86_irq_enable() { host_eflags |= X86_EFLAGS_IF; }
+
+static inline void x86_irq_disable() { host_eflags &= ~X86_EFLAGS_IF; }
+
+static inline unsigned long x86_irq_save() {
+  const unsigned long flags = host_eflags;
+
+  x86_irq_disable();
+  return flags;
+}
+
+static inline void x86_irq_restore(unsigned long flags) {
+  if (flags & X86_EFLAGS_IF)
+    x86_irq_enable();
+}
+
+#define DEFINE_PER_CPU(type, name) __thread __typeof__(type) name
+#define DECLARE_PER_CPU(type, name) extern __thread __typeof__(type) name
+
+#define this_cpu_read(var) (var)
+#define this_cpu_write(var, val) ((var) = (val))
+#define this_cpu_add(var, val) ((var) += (val))
+#define this_cpu_or(var, val) ((var) |= (val))
+#define this_cpu_inc(var) ((var)++)
+#define this_cpu_ptr(var) (&(var))
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* HOST_KERNEL_H */
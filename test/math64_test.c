@@ -0,0 +1,79 @@
+// make test, or:
+// cc -std=gnu11 -Iinclude -o math64_test test/math64_test.c && ./math64_test
+//
+// Without CONFIG_X86_64, this runs the divl path of the 32 bit kernel.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <math64.h>
+
+static int failures;
+
+/* xorshift64, so that runs are repeatable. */
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t random_u64() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+  return random_state;
+}
+
+static void check_div(uint64_t dividend, uint32_t divisor) {
+  const uint64_t ret = div_u64_u32(dividend, divisor);
+
+  if (ret != dividend / divisor) {
+    printf("div_u64_u32(%llu, %u) = %llu, expected %llu\n",
+           (unsigned long long)dividend, divisor, (unsigned long long)ret,
+           (unsigned long long)(dividend / divisor));
+    failures++;
+  }
+}
+
+static void check_mul_shr(uint64_t a, uint32_t mul, unsigned int shift) {
+  const uint64_t ret = mul_u64_u32_shr(a, mul, shift);
+  const uint64_t expect = (uint64_t)(((unsigned __int128)a * mul) >> shift);
+
+  if (ret != expect) {
+    printf("mul_u64_u32_shr(%llu, %u, %u) = %llu, expected %llu\n",
+           (unsigned long long)a, mul, shift, (unsigned long long)ret,
+           (unsigned long long)expect);
+    failures++;
+  }
+}
+
+int main() {
+  static const uint64_t dividends[] = {
+      0, 1, 0xFFFFFFFFULL, 0x100000000ULL, 0xFFFFFFFFFFFFFFFFULL,
+      1000000000ULL * 3600 * 24 * 365,
+  };
+  static const uint32_t divisors[] = {1, 2, 3, 1000, 1000000000U, 0xFFFFFFFFU};
+
+  for (size_t i = 0; i < sizeof(dividends) / sizeof(*dividends); ++i) {
+    for (size_t j = 0; j < sizeof(divisors) / sizeof(*divisors); ++j)
+      check_div(dividends[i], divisors[j]);
+  }
+
+  for (int i = 0; i < 100000; ++i) {
+    const uint64_t a = random_u64() >> (random_u64() % 64);
+    const uint32_t divisor = (uint32_t)random_u64() >> (random_u64() % 32);
+    const uint32_t mul = (uint32_t)random_u64();
+    const unsigned int shift = (unsigned int)(random_u64() % 33);
+
+    if (divisor != 0)
+      check_div(a, divisor);
+
+    /* Callers keep the result within 64 bits, as clock conversions do. */
+    if ((((unsigned __int128)a * mul) >> shift) >> 64 == 0)
+      check_mul_shr(a, mul, shift);
+  }
+
+  /* Nanoseconds from ten years of cycles at 3 GHz, in 32.32 fixed point. */
+  check_mul_shr(3000000000ULL * 3600 * 24 * 3650, 0x55555555U, 32);
+
+  if (failures != 0)
+    return EXIT_FAILURE;
+  printf("math64_test passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// make test, or:
+// cc -std=gnu11 -O2 -Iinclude -pthread -o steal_queue_test test/sched/steal_queue_test.c && ./steal_queue_test
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/sched/steal_queue.c"
+
+#define THIEF_COUNT 3
+#define ITEM_COUNT 500000UL
+
+static int failures;
+
+static struct steal_queue queue;
+static unsigned char popped[ITEM_COUNT + 1];
+static bool producer_done;
+
+static void test_fifo() {
+  struct steal_queue q = {0};
+
+  if (steal_queue_pop(&q) != NULL) {
+    printf("fifo: empty queue popped an item\n");
+    failures++;
+  }
+
+  for (uintptr_t i = 1; i <= STEAL_QUEUE_SIZE; ++i) {
+    if (steal_queue_push(&q, (void *)i) != 0) {
+      printf("fifo: push %lu failed\n", (unsigned long)i);
+      failures++;
+    }
+  }
+  if (steal_queue_push(&q, (void *)1) != -1 ||
+      steal_queue_size(&q) != STEAL_QUEUE_SIZE) {
+    printf("fifo: full queue took an item\n");
+    failures++;
+  }
+
+  /* Indices go around the ring several times. */
+  for (uintptr_t i = 1; i <= 10 * STEAL_QUEUE_SIZE; ++i) {
+    const uintptr_t item = (uintptr_t)steal_queue_pop(&q);
+
+    if (item != i) {
+      printf("fifo: popped %lu, expected %lu\n", (unsigned long)item,
+             (unsigned long)i);
+      failures++;
+      return;
+    }
+    steal_queue_push(&q, (void *)(i + STEAL_QUEUE_SIZE));
+  }
+}
+
+/**
+ * @brief Record an item popped by a consumer, whose own items should come
+ * out in the order they went in.
+ */
+static void record(uintptr_t item, uintptr_t *last) {
+  if (item <= *last) {
+    printf("race: popped %lu after %lu\n", (unsigned long)item,
+           (unsigned long)*last);
+    __atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);
+  }
+  *last = item;
+  __atomic_add_fetch(&popped[item], 1, __ATOMIC_RELAXED);
+}
+
+static void *thief(void *arg) {
+  uintptr_t last = 0;
+
+  while (1) {
+    const uintptr_t item = (uintptr_t)steal_queue_pop(&queue);
+
+    if (item != 0) {
+      record(item, &last);
+    } else if (__atomic_load_n(&producer_done, __ATOMIC_ACQUIRE) &&
+               steal_queue_size(&queue) == 0) {
+      break;
+    } else {
+      /* Host may have fewer processors than threads. */
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+/**
+ * The owner pushes while thieves pop, and pops its own items too,
+ * racing with the thieves for the last ones.
+ */
+static void test_race() {
+  pthread_t thieves[THIEF_COUNT];
+  uintptr_t next = 1, last = 0;
+
+  for (int i = 0; i < THIEF_COUNT; ++i)
+    pthread_create(&thieves[i], NULL, thief, NULL);
+
+  while (next <= ITEM_COUNT) {
+    if (steal_queue_push(&queue, (void *)next) == 0)
+      next++;
+    else
+      sched_yield();
+
+    if ((next & 7) == 0) {
+      const uintptr_t item = (uintptr_t)steal_queue_pop(&queue);
+
+      if (item != 0)
+        record(item, &last);
+    }
+  }
+  __atomic_store_n(&producer_done, true, __ATOMIC_RELEASE);
+
+  for (int i = 0; i < THIEF_COUNT; ++i)
+    pthread_join(thieves[i], NULL);
+
+  for (uintptr_t i = 1; i <= ITEM_COUNT; ++i) {
+    if (popped[i] != 1) {
+      printf("race: item %lu popped %u times\n", (unsigned long)i,
+             popped[i]);
+      failures++;
+      break;
+    }
+  }
+}
+
+int main() {
+  test_fifo();
+  test_race();
+
+  if (failures != 0)
+    return EXIT_FAILURE;
+  printf("steal_queue_test passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+// make test, or:
+// c++ -std=gnu++17 -Iinclude -pthread -o task_test test/sched/task_test.cpp && ./task_test
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <base.h>
+
+#include "../host_kernel.h"
+
+#include "../../src/sched/task.cpp"
+
+#define RACE_ROUNDS 20000
+
+static int failures;
+
+DEFINE_PER_CPU(uint32_t, softirq_pending);
+
+static softirq_handler_t task_softirq;
+
+void softirq_register(enum softirq nr, softirq_handler_t handler) {
+  if (nr == SOFTIRQ_TASK)
+    task_softirq = handler;
+}
+
+/* Threads play processors with interrupts enabled, so tasks run right away. */
+void softirq_run_pending() {
+  while ((host_eflags & X86_EFLAGS_IF) &&
+         (this_cpu_read(softirq_pending) & (1U << SOFTIRQ_TASK))) {
+    this_cpu_write(softirq_pending, 0);
+    task_softirq();
+  }
+}
+
+static void expect(bool cond, const char *what) {
+  if (!cond) {
+    printf("%s\n", what);
+    __atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);
+  }
+}
+
+struct counted_task {
+  struct task task;
+  struct future *future;
+  unsigned int runs;
+  bool done;
+  int result;
+};
+
+static void counted_task_fn(struct task *task) {
+  struct counted_task *counted = container_of(task, struct counted_task, task);
+
+  __atomic_add_fetch(&counted->runs, 1, __ATOMIC_RELAXED);
+  counted->done = future_done(counted->future);
+  counted->result = future_result(counted->future);
+}
+
+static void counted_task_init(struct counted_task *counted,
+                              struct future *future) {
+  task_init(&counted->task, counted_task_fn);
+  counted->future = future;
+  counted->runs = 0;
+  counted->done = false;
+  counted->result = 0;
+}
+
+static void test_then_before_complete() {
+  struct future future = FUTURE_INIT;
+  struct counted_task counted;
+
+  counted_task_init(&counted, &future);
+  future_then(&future, &counted.task);
+  expect(counted.runs == 0, "then: task ran before the completion");
+
+  expect(future_complete(&future, 42) == 0, "then: completion failed");
+  expect(counted.runs == 1 && counted.done && counted.result == 42,
+         "then: task did not see the result");
+
+  expect(future_complete(&future, 7) == -1, "then: completed twice");
+  expect(future_result(&future) == 42, "then: result was overwritten");
+}
+
+static void test_complete_before_then() {
+  struct future future = FUTURE_INIT;
+  struct counted_task counted;
+
+  counted_task_init(&counted, &future);
+  expect(future_complete(&future, 5) == 0, "done: completion failed");
+  expect(future_done(&future), "done: future is not done");
+
+  future_then(&future, &counted.task);
+  expect(counted.runs == 1 && counted.result == 5,
+         "done: task did not run on a done future");
+
+  /* Reused future is pending again. */
+  future_init(&future);
+  expect(!future_done(&future), "reuse: future is still done");
+  future_then(&future, &counted.task);
+  expect(future_complete(&future, 6) == 0 && counted.runs == 2 &&
+             counted.result == 6,
+         "reuse: task did not run on the second completion");
+}
+
+static void test_schedule_once() {
+  struct future future = FUTURE_INIT;
+  struct counted_task counted;
+  unsigned long flags;
+
+  counted_task_init(&counted, &future);
+
+  /* Queued twice before the softirq gets to run. */
+  flags = x86_irq_save();
+  expect(task_schedule(&counted.task), "queue: first queueing failed");
+  expect(!task_schedule(&counted.task), "queue: queued twice");
+  x86_irq_restore(flags);
+  softirq_run_pending();
+
+  expect(counted.runs == 1, "queue: task did not run once");
+}
+
+static struct future race_future;
+static struct counted_task race_task;
+static int race_won[2];
+static pthread_barrier_t race_barrier;
+
+static void *race_completer(void *arg) {
+  const int id = (int)(intptr_t)arg;
+
+  for (int round = 0; round < RACE_ROUNDS; ++round) {
+    pthread_barrier_wait(&race_barrier);
+    race_won[id] = future_complete(&race_future, round * 2 + id) == 0;
+    pthread_barrier_wait(&race_barrier);
+  }
+  return nullptr;
+}
+
+/**
+ * Two completers race with future_then on the same future, so that
+ * the continuation is set while the future is being completed.
+ */
+static void test_race() {
+  pthread_t completers[2];
+
+  pthread_barrier_init(&race_barrier, nullptr, 3);
+  for (int id = 0; id < 2; ++id)
+    pthread_create(&completers[id], nullptr, race_completer,
+                   (void *)(intptr_t)id);
+
+  for (int round = 0; round < RACE_ROUNDS; ++round) {
+    future_init(&race_future);
+    counted_task_init(&race_task, &race_future);
+
+    pthread_barrier_wait(&race_barrier);
+    future_then(&race_future, &race_task.task);
+    /* Continuation has run by now, on whichever thread queued it. */
+    pthread_barrier_wait(&race_barrier);
+
+    if (failures == 0 &&
+        (race_won[0] + race_won[1] != 1 || race_task.runs != 1 ||
+         !race_task.done ||
+         race_task.result != round * 2 + (race_won[0] ? 0 : 1))) {
+      printf("race: round %d won %d+%d, ran %u times with %d\n", round,
+             race_won[0], race_won[1], race_task.runs, race_task.result);
+      failures++;
+    }
+  }
+
+  for (int id = 0; id < 2; ++id)
+    pthread_join(completers[id], nullptr);
+  pthread_barrier_destroy(&race_barrier);
+}
+
+int main() {
+  executor_init();
+
+  test_then_before_complete();
+  test_complete_before_then();
+  test_schedule_once();
+  test_race();
+
+  if (failures != 0)
+    return EXIT_FAILURE;
+  printf("task_test passed.\n");
+  return EXIT_SUCCESS;
+}
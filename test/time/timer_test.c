@@ -0,0 +1,329 @@
+// make test, or:
+// cc -std=gnu11 -Iinclude -pthread -o timer_test test/time/timer_test.c && ./timer_test
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../host_kernel.h"
+
+#include "../../src/time/timer.c"
+
+#define TICK_NS ((uint64_t)1 << TIMER_TICK_SHIFT)
+
+static int failures;
+
+/* Clock and clock event of the processor running timer_softirq. */
+static uint64_t now_ns;
+static uint64_t event_ns;
+static bool event_armed;
+static unsigned int wakeups;
+
+DEFINE_PER_CPU(uint32_t, softirq_pending);
+
+void softirq_register(enum softirq nr, softirq_handler_t handler) {}
+
+uint64_t ktime_get_ns() { return now_ns; }
+
+void clockevent_program(uint64_t deadline_ns) {
+  event_ns = deadline_ns;
+  event_armed = true;
+}
+
+void clockevent_cancel() { event_armed = false; }
+
+/**
+ * @brief Move the clock to each clock event up to limit_ns in turn,
+ * and then to limit_ns.
+ */
+static void run_until(uint64_t limit_ns) {
+  while (event_armed && event_ns <= limit_ns) {
+    if (event_ns > now_ns)
+      now_ns = event_ns;
+    event_armed = false;
+    wakeups++;
+    timer_softirq();
+  }
+
+  if (limit_ns > now_ns)
+    now_ns = limit_ns;
+}
+
+/* Jump to the time with nothing pending, so that clk catches up. */
+static void settle(uint64_t at_ns) {
+  now_ns = at_ns;
+  timer_softirq();
+}
+
+struct checked_timer {
+  struct timer timer;
+  uint64_t deadline_ns;
+  unsigned int fired;
+  bool late_ok;
+};
+
+static void checked_timer_fn(void *ctx) {
+  struct checked_timer *checked = ctx;
+
+  checked->fired++;
+  if (now_ns < checked->deadline_ns ||
+      (!checked->late_ok && now_ns - checked->deadline_ns >= TICK_NS)) {
+    printf("timer for %llu fired at %llu\n",
+           (unsigned long long)checked->deadline_ns,
+           (unsigned long long)now_ns);
+    failures++;
+  }
+}
+
+static void checked_timer_add(struct checked_timer *checked,
+                              uint64_t deadline_ns, timer_fn_t fn) {
+  checked->deadline_ns = deadline_ns;
+  checked->fired = 0;
+  checked->late_ok = false;
+  timer_add(&checked->timer, deadline_ns, fn, checked);
+}
+
+static void expect_fired(const char *name, const struct checked_timer *checked,
+                         unsigned int fired) {
+  if (checked->fired != fired) {
+    printf("%s: timer for %llu fired %u times, expected %u\n", name,
+           (unsigned long long)checked->deadline_ns, checked->fired, fired);
+    failures++;
+  }
+}
+
+/* Ticks from clk around the edges of each level, and past the last one. */
+static const uint64_t boundary_ticks[] = {
+    0,
+    1,
+    TIMER_LEVEL0_SIZE - 1,
+    TIMER_LEVEL0_SIZE,
+    TIMER_LEVEL0_SIZE + 1,
+    ((uint64_t)1 << TIMER_LEVEL_SHIFT(2)) - 1,
+    (uint64_t)1 << TIMER_LEVEL_SHIFT(2),
+    ((uint64_t)1 << TIMER_LEVEL_SHIFT(2)) + 1,
+    ((uint64_t)1 << TIMER_LEVEL_SHIFT(3)) - 1,
+    (uint64_t)1 << TIMER_LEVEL_SHIFT(3),
+    ((uint64_t)1 << TIMER_LEVEL_SHIFT(3)) + 1,
+    TIMER_RANGE - 1,
+    TIMER_RANGE,
+    TIMER_RANGE + 1,
+    3 * TIMER_RANGE + 12345,
+};
+
+#define BOUNDARY_COUNT (sizeof(boundary_ticks) / sizeof(*boundary_ticks))
+
+static void check_boundaries(const char *name, uint64_t start_ns) {
+  struct checked_timer timers[BOUNDARY_COUNT] = {0};
+
+  for (size_t i = 0; i < BOUNDARY_COUNT; ++i) {
+    /* Off the tick, so that rounding up is covered too. */
+    checked_timer_add(&timers[i],
+                      start_ns + boundary_ticks[i] * TICK_NS + TICK_NS / 3,
+                      checked_timer_fn);
+  }
+
+  run_until(start_ns + 4 * TIMER_RANGE * TICK_NS);
+
+  for (size_t i = 0; i < BOUNDARY_COUNT; ++i)
+    expect_fired(name, &timers[i], 1);
+  if (event_armed) {
+    printf("%s: clock event left armed\n", name);
+    failures++;
+  }
+}
+
+static void test_level_boundaries() {
+  settle(1000 * TICK_NS);
+  check_boundaries("level boundaries", now_ns);
+}
+
+/**
+ * Slot indices of each level wrap around as clk goes, so timers are
+ * added right before clk crosses the end of each level.
+ */
+static void test_clock_wrap() {
+  uint64_t start_tick = 1000 * TIMER_RANGE;
+
+  for (unsigned int level = 1; level <= TIMER_LEVELS; ++level) {
+    const uint64_t level_ticks = (uint64_t)1 << TIMER_LEVEL_SHIFT(level);
+
+    for (uint64_t before = 1; before <= 3; ++before) {
+      start_tick = (start_tick / level_ticks + 8) * level_ticks - before;
+      settle(start_tick * TICK_NS);
+      check_boundaries("clock wrap", now_ns);
+      start_tick = now_ns / TICK_NS;
+    }
+  }
+}
+
+/**
+ * Nothing runs the wheel while it is empty, so clk falls behind
+ * the clock, and timers are added relative to a stale clk.
+ */
+static void test_stale_clk() {
+  static const uint64_t idle_ticks[] = {
+      TIMER_LEVEL0_SIZE + 7,
+      ((uint64_t)1 << TIMER_LEVEL_SHIFT(2)) + 7,
+      ((uint64_t)1 << TIMER_LEVEL_SHIFT(3)) + 7,
+      5 * TIMER_RANGE + 7,
+  };
+  struct checked_timer late = {0}, timers[BOUNDARY_COUNT] = {0};
+
+  for (size_t i = 0; i < sizeof(idle_ticks) / sizeof(*idle_ticks); ++i) {
+    settle(now_ns + 2 * TIMER_RANGE * TICK_NS);
+    now_ns += idle_ticks[i] * TICK_NS;
+    check_boundaries("stale clk", now_ns);
+  }
+
+  /* Clock event fires late, after a timer added meanwhile is due. */
+  settle(now_ns + 2 * TIMER_RANGE * TICK_NS);
+  checked_timer_add(&late, now_ns + 10 * TICK_NS, checked_timer_fn);
+  late.late_ok = true;
+  now_ns += 3 * TIMER_RANGE * TICK_NS;
+  for (size_t i = 0; i < BOUNDARY_COUNT; ++i)
+    checked_timer_add(&timers[i], now_ns + boundary_ticks[i] * TICK_NS,
+                      checked_timer_fn);
+  run_until(now_ns + 4 * TIMER_RANGE * TICK_NS);
+
+  expect_fired("late event", &late, 1);
+  for (size_t i = 0; i < BOUNDARY_COUNT; ++i)
+    expect_fired("late event", &timers[i], 1);
+}
+
+/* Ticks with nothing to do are skipped rather than walked. */
+static void test_skip_ahead() {
+  struct checked_timer timer = {0};
+
+  settle(now_ns + 2 * TIMER_RANGE * TICK_NS);
+  wakeups = 0;
+  checked_timer_add(&timer, now_ns + (TIMER_RANGE - 1) * TICK_NS,
+                    checked_timer_fn);
+  run_until(now_ns + TIMER_RANGE * TICK_NS);
+
+  expect_fired("skip ahead", &timer, 1);
+  if (wakeups > 2 * TIMER_LEVELS) {
+    printf("skip ahead: %u wakeups\n", wakeups);
+    failures++;
+  }
+}
+
+#define BATCH_SIZE 4
+
+static struct checked_timer batch[BATCH_SIZE];
+static unsigned int batch_cancelled;
+static unsigned int batch_rearm;
+
+/* First of the batch to run cancels the others. */
+static void batch_cancel_fn(void *ctx) {
+  checked_timer_fn(ctx);
+
+  for (unsigned int i = 0; i < BATCH_SIZE; ++i) {
+    if (timer_cancel(&batch[i].timer))
+      batch_cancelled++;
+  }
+}
+
+/* Each of the batch puts itself back once it runs. */
+static void batch_rearm_fn(void *ctx) {
+  struct checked_timer *checked = ctx;
+
+  checked_timer_fn(ctx);
+  if (checked->fired < batch_rearm) {
+    checked->deadline_ns = now_ns + TICK_NS;
+    timer_add(&checked->timer, checked->deadline_ns, batch_rearm_fn, checked);
+  }
+}
+
+static void test_cancel_during_expiry() {
+  const uint64_t deadline_ns = now_ns + 100 * TICK_NS;
+  struct checked_timer later = {0};
+  unsigned int fired = 0;
+
+  /* Timers of the same slot, and one a tick later. */
+  for (unsigned int i = 0; i < BATCH_SIZE; ++i)
+    checked_timer_add(&batch[i], deadline_ns, batch_cancel_fn);
+  checked_timer_add(&later, deadline_ns + TICK_NS, checked_timer_fn);
+  run_until(deadline_ns + 2 * TICK_NS);
+
+  for (unsigned int i = 0; i < BATCH_SIZE; ++i)
+    fired += batch[i].fired;
+  if (fired != 1 || batch_cancelled != BATCH_SIZE - 1) {
+    printf("cancel during expiry: %u fired, %u cancelled\n", fired,
+           batch_cancelled);
+    failures++;
+  }
+  expect_fired("cancel during expiry", &later, 1);
+
+  batch_rearm = 3;
+  for (unsigned int i = 0; i < BATCH_SIZE; ++i)
+    checked_timer_add(&batch[i], now_ns + TICK_NS, batch_rearm_fn);
+  run_until(now_ns + 10 * TICK_NS);
+
+  for (unsigned int i = 0; i < BATCH_SIZE; ++i)
+    expect_fired("rearm during expiry", &batch[i], batch_rearm);
+}
+
+static struct timer sync_timer;
+static int sync_state;
+
+enum {
+  SYNC_IDLE,
+  SYNC_RUNNING,
+  SYNC_RELEASED,
+  SYNC_DONE,
+};
+
+static void sync_timer_fn(void *ctx) {
+  __atomic_store_n(&sync_state, SYNC_RUNNING, __ATOMIC_RELEASE);
+  while (__atomic_load_n(&sync_state, __ATOMIC_ACQUIRE) != SYNC_RELEASED)
+    x86_pause();
+  usleep(10000);
+  __atomic_store_n(&sync_state, SYNC_DONE, __ATOMIC_RELEASE);
+}
+
+static void *sync_cancel_thread(void *arg) {
+  while (__atomic_load_n(&sync_state, __ATOMIC_ACQUIRE) != SYNC_RUNNING)
+    x86_pause();
+  __atomic_store_n(&sync_state, SYNC_RELEASED, __ATOMIC_RELEASE);
+
+  /* Callback has started, so the timer is no longer pending. */
+  if (timer_cancel_sync(&sync_timer)) {
+    printf("cancel sync: running timer was pending\n");
+    failures++;
+  }
+  if (__atomic_load_n(&sync_state, __ATOMIC_ACQUIRE) != SYNC_DONE) {
+    printf("cancel sync: returned while the callback runs\n");
+    failures++;
+  }
+  return NULL;
+}
+
+static void test_cancel_sync() {
+  pthread_t thread;
+
+  timer_add(&sync_timer, now_ns + TICK_NS, sync_timer_fn, NULL);
+  if (!timer_cancel_sync(&sync_timer)) {
+    printf("cancel sync: pending timer was not cancelled\n");
+    failures++;
+  }
+
+  timer_add(&sync_timer, now_ns + TICK_NS, sync_timer_fn, NULL);
+  pthread_create(&thread, NULL, sync_cancel_thread, NULL);
+  run_until(now_ns + 2 * TICK_NS);
+  pthread_join(thread, NULL);
+}
+
+int main() {
+  test_level_boundaries();
+  test_clock_wrap();
+  test_stale_clk();
+  test_skip_ahead();
+  test_cancel_during_expiry();
+  test_cancel_sync();
+
+  if (failures != 0)
+    return EXIT_FAILURE;
+  printf("timer_test passed.\n");
+  return EXIT_SUCCESS;
+}
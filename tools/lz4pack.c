@@ -0,0 +1,262 @@
+/**
+ * Host tool to produce the compressed kernel payload.
+ *
+ * All PT_LOAD segments of the kernel ELF image are laid out as a flat image
+ * at their physical addresses, which is then compressed as a single LZ4 block.
+ * The payload layout is described in <boot/lz4.h>.
+ *
+ * Usage: lz4pack [KERNEL_ELF] [OUTPUT]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boot/elf.h>
+#include <boot/lz4.h>
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LENGTH_MASK 0x0F
+#define LZ4_MAX_OFFSET 0xFFFF
+/* The last match should start at least 12 bytes before the end of input. */
+#define LZ4_MATCH_START_LIMIT 12
+/* The last 5 bytes of input are always literals. */
+#define LZ4_LAST_LITERALS 5
+
+#define LZ4_HASH_BITS 16
+
+static uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t lz4_hash(uint32_t v) {
+  return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t *lz4_put_length(uint8_t *op, size_t length) {
+  while (length >= 0xFF) {
+    *op++ = 0xFF;
+    length -= 0xFF;
+  }
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+static uint8_t *lz4_put_sequence(uint8_t *op, const uint8_t *literals,
+                                 size_t literal_length, size_t offset,
+                                 size_t match_length) {
+  uint8_t *token = op++;
+  size_t match_code = match_length - LZ4_MIN_MATCH;
+
+  *token = 0;
+
+  if (literal_length >= LZ4_LENGTH_MASK) {
+    *token |= LZ4_LENGTH_MASK << 4;
+    op = lz4_put_length(op, literal_length - LZ4_LENGTH_MASK);
+  } else {
+    *token |= (uint8_t)(literal_length << 4);
+  }
+
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+
+  /* Last sequence has literals only. */
+  if (match_length == 0)
+    return op;
+
+  *op++ = (uint8_t)offset;
+  *op++ = (uint8_t)(offset >> 8);
+
+  if (match_code >= LZ4_LENGTH_MASK) {
+    *token |= LZ4_LENGTH_MASK;
+    op = lz4_put_length(op, match_code - LZ4_LENGTH_MASK);
+  } else {
+    *token |= (uint8_t)match_code;
+  }
+
+  return op;
+}
+
+/**
+ * @brief Greedy single pass LZ4 block compressor.
+ *
+ * @return size_t Size of compressed block. dst should hold at least
+ * lz4_compress_bound(src_size) bytes.
+ */
+static size_t lz4_compress(const uint8_t *src, size_t src_size, uint8_t *dst) {
+  /* Positions are stored off by one, so that 0 stands for empty. */
+  static uint32_t table[1U << LZ4_HASH_BITS];
+  size_t ip = 0, anchor = 0;
+  uint8_t *op = dst;
+
+  memset(table, 0, sizeof(table));
+
+  if (src_size > LZ4_MATCH_START_LIMIT) {
+    const size_t match_start_limit = src_size - LZ4_MATCH_START_LIMIT;
+    const size_t match_end_limit = src_size - LZ4_LAST_LITERALS;
+
+    while (ip < match_start_limit) {
+      const uint32_t sequence = read32(src + ip);
+      const uint32_t h = lz4_hash(sequence);
+      const size_t ref = table[h];
+      size_t match_length;
+
+      table[h] = (uint32_t)(ip + 1);
+
+      if (ref == 0 || ip - (ref - 1) > LZ4_MAX_OFFSET ||
+          read32(src + ref - 1) != sequence) {
+        ip++;
+        continue;
+      }
+
+      match_length = LZ4_MIN_MATCH;
+      while (ip + match_length < match_end_limit &&
+             src[ref - 1 + match_length] == src[ip + match_length])
+        match_length++;
+
+      op = lz4_put_sequence(op, src + anchor, ip - anchor, ip - (ref - 1),
+                            match_length);
+
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+
+  op = lz4_put_sequence(op, src + anchor, src_size - anchor, 0, 0);
+
+  return (size_t)(op - dst);
+}
+
+static size_t lz4_compress_bound(size_t size) { return size + size / 255 + 16; }
+
+static void *read_file(const char *path, size_t *size) {
+  FILE *fp = fopen(path, "rb");
+  void *buf = NULL;
+  long len;
+
+  if (fp == NULL)
+    return NULL;
+
+  if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0 &&
+      fseek(fp, 0, SEEK_SET) == 0) {
+    buf = malloc((size_t)len);
+    if (buf != NULL && fread(buf, 1, (size_t)len, fp) != (size_t)len) {
+      free(buf);
+      buf = NULL;
+    }
+    *size = (size_t)len;
+  }
+
+  fclose(fp);
+  return buf;
+}
+
+static const struct elf32_phdr *elf_phdr(const uint8_t *elf,
+                                         const struct elf32_ehdr *ehdr,
+                                         int index) {
+  return (const struct elf32_phdr *)(elf + ehdr->phoff +
+                                     (size_t)index * ehdr->phentsize);
+}
+
+int main(int argc, char *argv[]) {
+  const struct elf32_ehdr *ehdr;
+  struct lz4_kernel_header header;
+  uint8_t *elf, *image, *compressed;
+  size_t elf_size, compressed_size;
+  uint32_t load_start = UINT32_MAX, image_end = 0, mem_end = 0;
+  FILE *fp;
+
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s [KERNEL_ELF] [OUTPUT]\n", argv[0]);
+    return 1;
+  }
+
+  elf = read_file(argv[1], &elf_size);
+  if (elf == NULL) {
+    fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  ehdr = (const struct elf32_ehdr *)elf;
+  if (elf_size < sizeof(*ehdr) ||
+      memcmp(ehdr->ident, ELF_MAGIC, ELF_MAGIC_SIZE) ||
+      ehdr->ident[ELF_IDENT_CLASS] != ELF_CLASS_32 ||
+      ehdr->phentsize < sizeof(struct elf32_phdr) ||
+      ehdr->phoff + (size_t)ehdr->phnum * ehdr->phentsize > elf_size) {
+    fprintf(stderr, "%s: %s is not a 32 bit ELF image\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  for (int i = 0; i < ehdr->phnum; ++i) {
+    const struct elf32_phdr *phdr = elf_phdr(elf, ehdr, i);
+
+    if (phdr->type != ELF_PT_LOAD || phdr->memsz == 0)
+      continue;
+
+    if ((size_t)phdr->offset + phdr->filesz > elf_size ||
+        phdr->filesz > phdr->memsz) {
+      fprintf(stderr, "%s: malformed segment %d\n", argv[0], i);
+      return 1;
+    }
+
+    if (phdr->paddr < load_start)
+      load_start = phdr->paddr;
+    if (phdr->paddr + phdr->filesz > image_end)
+      image_end = phdr->paddr + phdr->filesz;
+    if (phdr->paddr + phdr->memsz > mem_end)
+      mem_end = phdr->paddr + phdr->memsz;
+  }
+
+  if (load_start >= image_end) {
+    fprintf(stderr, "%s: no loadable segment\n", argv[0]);
+    return 1;
+  }
+
+  /* Gaps between segments and zero filled tails are left as zero. */
+  image = calloc(image_end - load_start, 1);
+  compressed = malloc(lz4_compress_bound(image_end - load_start));
+  if (image == NULL || compressed == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 0; i < ehdr->phnum; ++i) {
+    const struct elf32_phdr *phdr = elf_phdr(elf, ehdr, i);
+
+    if (phdr->type != ELF_PT_LOAD || phdr->memsz == 0)
+      continue;
+
+    memcpy(image + (phdr->paddr - load_start), elf + phdr->offset,
+           phdr->filesz);
+  }
+
+  compressed_size = lz4_compress(image, image_end - load_start, compressed);
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LZ4_KERNEL_MAGIC, LZ4_KERNEL_MAGIC_SIZE);
+  header.header_size = sizeof(header);
+  header.entry = ehdr->entry;
+  header.load_addr = load_start;
+  header.image_size = image_end - load_start;
+  header.mem_size = mem_end - load_start;
+  header.compressed_size = (uint32_t)compressed_size;
+
+  fp = fopen(argv[2], "wb");
+  if (fp == NULL || fwrite(&header, sizeof(header), 1, fp) != 1 ||
+      fwrite(compressed, 1, compressed_size, fp) != compressed_size ||
+      fclose(fp) != 0) {
+    fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[2]);
+    return 1;
+  }
+
+  printf("lz4pack: %s %u -> %zu bytes (%.1f%%)\n", argv[2], header.image_size,
+         compressed_size, 100.0 * compressed_size / header.image_size);
+
+  free(elf);
+  free(image);
+  free(compressed);
+
+  return 0;
+}